@@ -0,0 +1,409 @@
+/*****************************************
+ * Allocators for Quadratic_hash_table
+ *
+ * Keshav Kanatala
+ *
+ * The storage of a hash table (its entries and its control bytes)
+ * comes from its Alloc template argument, through
+ * std::allocator_traits.  The default is std::allocator.
+ *
+ *   Aligned_allocator<Type, Alignment>
+ *       Every block starts on an Alignment-byte boundary (by default
+ *       a cache line, 64 bytes), so a group of bins never straddles
+ *       more cache lines than it must.  Blocks of at least
+ *       huge_page_size bytes are aligned to a huge page instead and,
+ *       where the system supports transparent huge pages, marked with
+ *       madvise(MADV_HUGEPAGE): a multi-gigabyte table then needs a
+ *       TLB entry per 2 MiB rather than per 4 KiB, and a probe rarely
+ *       misses in the TLB.
+ *
+ *   Arena and Arena_allocator<Type>
+ *       An Arena hands out blocks by bumping a pointer through large
+ *       slabs and frees them all at once, when it is released or
+ *       destroyed.  A small table built on an Arena_allocator (see
+ *       Arena_hash_table in Quadratic_hash_table.h) costs no call to
+ *       the heap in its constructor or destructor: its entries and
+ *       its control bytes are carved from the current slab, and
+ *       freeing a block only gives back its space if it was the last
+ *       one carved.  Every table on an arena must be destroyed before
+ *       the arena is released.
+ *
+ * Blocks (and slabs) are taken from posix_memalign() or malloc() and
+ * returned with free(), so they are not recorded by the allocation
+ * tracking in ece250.h.
+ *****************************************/
+
+#ifndef ALLOCATORS_H
+#define ALLOCATORS_H
+
+#pragma push_macro("nullptr")
+#undef nullptr
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#pragma pop_macro("nullptr")
+
+template <typename Type, std::size_t Alignment = 64>
+class Aligned_allocator {
+public:
+    typedef Type value_type;
+
+    static const std::size_t huge_page_size = 2 * 1024 * 1024;
+
+    template <typename Other>
+    struct rebind {
+        typedef Aligned_allocator<Other, Alignment> other;
+    };
+
+    Aligned_allocator() {
+        // empty constructor
+    }
+
+    template <typename Other>
+    Aligned_allocator( Aligned_allocator<Other, Alignment> const & ) {
+        // empty constructor
+    }
+
+    Type *allocate( std::size_t n );
+    void deallocate( Type *ptr, std::size_t n );
+};
+
+/*
+ * Method: Type *allocate(std::size_t n)
+ *         Allocate uninitialized storage for n objects.
+ *
+ *         An exception (std::bad_alloc) is thrown if there is no memory
+ *
+ * Returns: storage aligned to Alignment bytes, or to a huge page if
+ *          it is at least huge_page_size bytes
+ */
+template <typename Type, std::size_t Alignment>
+Type *Aligned_allocator<Type, Alignment>::allocate( std::size_t n ) {
+    std::size_t bytes = n * sizeof( Type );
+    bool huge = bytes >= huge_page_size;
+    std::size_t alignment = huge ? huge_page_size : Alignment;
+    void *ptr = 0;
+
+    if ( huge ) {
+        // whole huge pages, so that the last one can be backed too
+        bytes = (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+    }
+
+    if ( alignment < sizeof( void * ) ) {
+        alignment = sizeof( void * );
+    }
+
+    if ( ::posix_memalign( &ptr, alignment, bytes == 0 ? 1 : bytes ) != 0 ) {
+        throw std::bad_alloc();
+    }
+
+#ifdef MADV_HUGEPAGE
+    if ( huge ) {
+        // only a hint: the block is usable whether or not it is honoured
+        ::madvise( ptr, bytes, MADV_HUGEPAGE );
+    }
+#endif
+
+    return static_cast<Type *>( ptr );
+}
+
+/*
+ * Method: void deallocate(Type *ptr, std::size_t n)
+ *         Return storage obtained from allocate().
+ */
+template <typename Type, std::size_t Alignment>
+void Aligned_allocator<Type, Alignment>::deallocate( Type *ptr, std::size_t ) {
+    std::free( ptr );
+}
+
+template <typename Type, typename Other, std::size_t Alignment>
+bool operator==( Aligned_allocator<Type, Alignment> const &, Aligned_allocator<Other, Alignment> const & ) {
+    return true;
+}
+
+template <typename Type, typename Other, std::size_t Alignment>
+bool operator!=( Aligned_allocator<Type, Alignment> const &, Aligned_allocator<Other, Alignment> const & ) {
+    return false;
+}
+
+/*
+ * Arena
+ *
+ * Slabs form a list, newest first; each starts with its slab header.
+ * Allocations larger than a quarter of a slab get a slab of their
+ * own so that they do not waste the rest of the current one.
+ */
+class Arena {
+private:
+    struct slab {
+        slab *next;             // the previously allocated slab
+        std::size_t size;       // bytes in the slab, header included
+    };
+
+    static const std::size_t align = 16;    // alignment of every block
+
+    std::size_t slab_size;      // size of a regular slab
+    slab *slabs;                // the slabs, newest first
+    char *top;                  // next free byte of the current slab
+    char *limit;                // end of the current slab
+    std::size_t in_use;         // bytes handed out and not given back
+    int n_slabs;                // number of slabs held
+
+public:
+    static const std::size_t default_slab_size = 64 * 1024;
+
+    // constructors
+    explicit Arena( std::size_t s = default_slab_size );
+    ~Arena();
+
+    // accessors
+    std::size_t used() const;
+    int slab_count() const;
+
+    // mutators
+    void *allocate( std::size_t bytes );
+    void deallocate( void *ptr, std::size_t bytes );
+    void release();
+
+private:
+    static std::size_t round( std::size_t bytes );
+    void *add_slab( std::size_t bytes, bool current );
+
+    // an arena cannot be copied
+    Arena( Arena const & );
+    Arena &operator=( Arena const & );
+};
+
+/*
+ * Constructor: Arena(std::size_t s)
+ *
+ * Creates an empty arena whose slabs hold s bytes; the first slab is
+ * allocated by the first request
+ */
+inline Arena::Arena( std::size_t s ):
+slab_size( s < 1024 ? 1024 : s ),
+slabs( 0 ),
+top( 0 ),
+limit( 0 ),
+in_use( 0 ),
+n_slabs( 0 ) {
+    // empty constructor
+}
+
+/*
+ * Destructor
+ */
+inline Arena::~Arena() {
+    while ( slabs != 0 ) {
+        slab *next = slabs->next;
+
+        std::free( slabs );
+        slabs = next;
+    }
+}
+
+/*
+ * Accessor: std::size_t used()
+ *
+ * Returns: the number of bytes handed out and not given back
+ */
+inline std::size_t Arena::used() const {
+    return in_use;
+}
+
+/*
+ * Accessor: int slab_count()
+ *
+ * Returns: the number of slabs the arena holds
+ */
+inline int Arena::slab_count() const {
+    return n_slabs;
+}
+
+/*
+ * Method: void *allocate(std::size_t bytes)
+ *         Carve a block from the current slab, starting a new slab if
+ *         it does not fit.
+ *
+ *         An exception (std::bad_alloc) is thrown if there is no memory
+ *
+ * Returns: a block of the given size aligned to 16 bytes
+ */
+inline void *Arena::allocate( std::size_t bytes ) {
+    bytes = round( bytes == 0 ? 1 : bytes );
+    in_use += bytes;
+
+    if ( bytes > static_cast<std::size_t>( limit - top ) ) {
+        if ( bytes > slab_size / 4 ) {
+            return add_slab( bytes, false );
+        }
+
+        add_slab( slab_size - round( sizeof( slab ) ), true );
+    }
+
+    void *ptr = top;
+    top += bytes;
+
+    return ptr;
+}
+
+/*
+ * Method: void deallocate(void *ptr, std::size_t bytes)
+ *         Give back a block.  Its space is reused only if it is the
+ *         last block carved from the current slab; otherwise it is
+ *         reclaimed when the arena is released.
+ */
+inline void Arena::deallocate( void *ptr, std::size_t bytes ) {
+    bytes = round( bytes == 0 ? 1 : bytes );
+    in_use -= bytes;
+
+    if ( static_cast<char *>( ptr ) + bytes == top ) {
+        top = static_cast<char *>( ptr );
+    }
+}
+
+/*
+ * Method: void release()
+ *         Free every block at once.  The most recent regular slab is
+ *         kept for the next round of allocations; every other slab is
+ *         returned to the system.
+ */
+inline void Arena::release() {
+    slab *keep = 0;
+
+    while ( slabs != 0 ) {
+        slab *next = slabs->next;
+
+        if ( keep == 0 && slabs->size == slab_size ) {
+            keep = slabs;
+        } else {
+            std::free( slabs );
+        }
+
+        slabs = next;
+    }
+
+    slabs = keep;
+    n_slabs = (keep == 0) ? 0 : 1;
+    in_use = 0;
+
+    if ( keep != 0 ) {
+        keep->next = 0;
+        top = reinterpret_cast<char *>( keep ) + round( sizeof( slab ) );
+        limit = reinterpret_cast<char *>( keep ) + keep->size;
+    } else {
+        top = limit = 0;
+    }
+}
+
+/*
+ * Accessor: std::size_t round(std::size_t bytes)
+ *
+ * Returns: bytes rounded up to a multiple of the alignment
+ */
+inline std::size_t Arena::round( std::size_t bytes ) {
+    return (bytes + align - 1) & ~(align - 1);
+}
+
+/*
+ * Method: void *add_slab(std::size_t bytes, bool current)
+ *         Allocate a slab with room for bytes after its header.  If
+ *         current is true the slab becomes the one blocks are carved
+ *         from; otherwise the whole slab is one block.
+ *
+ *         An exception (std::bad_alloc) is thrown if there is no memory
+ *
+ * Returns: the first usable byte of the slab
+ */
+inline void *Arena::add_slab( std::size_t bytes, bool current ) {
+    std::size_t size = round( sizeof( slab ) ) + bytes;
+    slab *s = static_cast<slab *>( std::malloc( size ) );
+
+    if ( s == 0 ) {
+        throw std::bad_alloc();
+    }
+
+    s->size = size;
+    n_slabs++;
+
+    char *first = reinterpret_cast<char *>( s ) + round( sizeof( slab ) );
+
+    if ( current || slabs == 0 ) {
+        s->next = slabs;
+        slabs = s;
+    } else {
+        // keep the current slab at the head of the list
+        s->next = slabs->next;
+        slabs->next = s;
+    }
+
+    if ( current ) {
+        top = first;
+        limit = reinterpret_cast<char *>( s ) + size;
+    }
+
+    return first;
+}
+
+/*
+ * Arena_allocator
+ *
+ * An allocator that takes its storage from an Arena.  It converts
+ * implicitly from an Arena, so a table on an arena is constructed
+ * with Arena_hash_table<int> table( 5, Default_hash<int>(), arena ).
+ * There is no default constructor: every allocator names its arena.
+ */
+template <typename Type>
+class Arena_allocator {
+private:
+    Arena *arena;
+
+    template <typename Other>
+    friend class Arena_allocator;
+
+public:
+    typedef Type value_type;
+
+    template <typename Other>
+    struct rebind {
+        typedef Arena_allocator<Other> other;
+    };
+
+    Arena_allocator( Arena &a ):
+    arena( &a ) {
+        // empty constructor
+    }
+
+    template <typename Other>
+    Arena_allocator( Arena_allocator<Other> const &a ):
+    arena( a.arena ) {
+        // empty constructor
+    }
+
+    Type *allocate( std::size_t n ) {
+        static_assert( alignof( Type ) <= 16, "the arena aligns blocks to 16 bytes" );
+
+        return static_cast<Type *>( arena->allocate( n * sizeof( Type ) ) );
+    }
+
+    void deallocate( Type *ptr, std::size_t n ) {
+        arena->deallocate( ptr, n * sizeof( Type ) );
+    }
+
+    Arena *source() const {
+        return arena;
+    }
+};
+
+template <typename Type, typename Other>
+bool operator==( Arena_allocator<Type> const &a, Arena_allocator<Other> const &b ) {
+    return a.source() == b.source();
+}
+
+template <typename Type, typename Other>
+bool operator!=( Arena_allocator<Type> const &a, Arena_allocator<Other> const &b ) {
+    return a.source() != b.source();
+}
+
+#endif
@@ -0,0 +1,461 @@
+/*****************************************
+ * Concurrent_hash_table
+ *
+ * Keshav Kanatala
+ *
+ * A lock-free open-addressing hash table of integers that may be
+ * used by any number of threads at once.
+ *
+ * Each bin is one 64-bit atomic word holding the state of the bin in
+ * the high half and the key in the low half, so a bin changes state
+ * and key together with a single compare-and-swap:
+ *
+ *   UNOCCUPIED  -> CLAIMED k       insert(k) claims the first free bin
+ *   ERASED      -> CLAIMED k       of the probe sequence of k
+ *   CLAIMED k   -> OCCUPIED k      no other bin holds or claims k
+ *   CLAIMED k   -> ERASED          another bin holds or claims k
+ *   OCCUPIED k  -> ERASED          erase(k)
+ *
+ * A claim is not yet an entry: member() and erase() pass over it.
+ * Before it becomes an entry, insert() examines the rest of the probe
+ * sequence of k.  If k is already there, the claim is withdrawn; if
+ * another thread claims k in an earlier bin, this thread withdraws
+ * and starts again, and if in a later bin, it waits until that claim
+ * is settled.  So every key is held by at most one bin and two
+ * threads inserting the same key cannot both succeed.
+ *
+ * member() and erase() never take a lock and never wait; insert()
+ * only waits for another insert() of the same key.
+ *
+ * A bin that has held a key never becomes unoccupied again, but any
+ * key may reuse an erased bin, so insert() throws overflow only when
+ * every bin holds or claims a key.  The table is not resized: as
+ * keys come and go, the erased bins lengthen the probe sequences of
+ * keys that are not in the table, until clear() is called.
+ *
+ * Type must be an integral type of at most 32 bits.
+ *****************************************/
+
+#ifndef CONCURRENT_HASH_TABLE_H
+#define CONCURRENT_HASH_TABLE_H
+
+#include "exception.h"
+#include "Hash_functions.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+
+template <typename Type, typename Hash = Default_hash<Type> >
+class Concurrent_hash_table {
+    static_assert( std::is_integral<Type>::value && sizeof( Type ) <= 4,
+                   "Concurrent_hash_table requires an integral type of at most 32 bits" );
+
+private:
+    typedef unsigned long long word;
+
+    // bin states, stored in the high half of a bin
+    static const word UNOCCUPIED = 0;
+    static const word OCCUPIED   = 1ULL << 32;
+    static const word ERASED     = 2ULL << 32;
+    static const word CLAIMED    = 3ULL << 32;
+    static const word STATE      = ~0ULL << 32;
+
+    // how a claim is settled, see settle()
+    enum claim_t { KEEP, DUPLICATE, WITHDRAW };
+
+    // the size is kept in several counters on separate cache lines so
+    // that threads inserting and erasing do not contend on one word
+    static const int stripes = 16;
+
+    struct alignas(64) counter {
+        std::atomic<long> value;
+    };
+
+    const int m = 5;            // default array size
+    int power;                  // array size is 2^power
+    int array_size;             // array size of the hash table
+    int mask;                   // array_size - 1
+    Hash hasher;                // hash function object
+    std::atomic<word> *array;   // state and key of each bin
+    counter counts[stripes];    // number of elements, in parts
+
+public:
+    // constructors
+    Concurrent_hash_table();
+    Concurrent_hash_table(int n, Hash const &h = Hash());
+    ~Concurrent_hash_table();
+
+    // accessors
+    int size() const;
+    int capacity() const;
+    double load_factor() const;
+    bool empty() const;
+    bool member(Type const &obj) const;
+
+    // mutators
+    bool insert(Type const &obj);
+    bool erase(Type const &obj);
+    void clear();
+
+private:
+    static word key_bits(Type const &obj);
+    word wait_for_claim(int bin, word key) const;
+    claim_t settle(int home, int step, word key) const;
+    std::atomic<long> &local_count();
+
+    // the table cannot be copied
+    Concurrent_hash_table(Concurrent_hash_table const &);
+    Concurrent_hash_table &operator=(Concurrent_hash_table const &);
+};
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Constructors and Destructor                                 * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Constructor: Concurrent_hash_table(int n, Hash const &h)
+ *
+ * Creates a new hash table with a capacity of 2^n that hashes its
+ * entries with h
+ */
+template <typename Type, typename Hash>
+Concurrent_hash_table<Type, Hash>::Concurrent_hash_table(int n, Hash const &h):
+power( n ),
+array_size( 1 << power ),
+mask( array_size - 1 ),
+hasher( h ),
+array( new std::atomic<word>[array_size] ) {
+    clear();
+}
+
+/*
+ * Constructor: Concurrent_hash_table()
+ *
+ * Creates a new hash table with a capacity of 2^5
+ */
+template <typename Type, typename Hash>
+Concurrent_hash_table<Type, Hash>::Concurrent_hash_table():
+power( m ),
+array_size( 1 << power ),
+mask( array_size - 1 ),
+hasher(),
+array( new std::atomic<word>[array_size] ) {
+    clear();
+}
+
+/*
+ * Destructor
+ */
+template <typename Type, typename Hash>
+Concurrent_hash_table<Type, Hash>::~Concurrent_hash_table() {
+    delete [] array;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Accessors                                                   * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: int size()
+ *
+ * Returns: the number of entries; while other threads insert or
+ *          erase, the result is only an approximation
+ */
+template <typename Type, typename Hash>
+int Concurrent_hash_table<Type, Hash>::size() const {
+    long total = 0;
+
+    for ( int i = 0; i < stripes; ++i ) {
+        total += counts[i].value.load( std::memory_order_relaxed );
+    }
+
+    return static_cast<int>( total );
+}
+
+/*
+ * Accessor: int capacity()
+ *
+ * Returns: the number of bins
+ */
+template <typename Type, typename Hash>
+int Concurrent_hash_table<Type, Hash>::capacity() const {
+    return array_size;
+}
+
+/*
+ * Accessor: double load_factor()
+ *
+ * Returns: size() / capacity()
+ */
+template <typename Type, typename Hash>
+double Concurrent_hash_table<Type, Hash>::load_factor() const {
+    return static_cast<double>( size() ) / capacity();
+}
+
+/*
+ * Accessor: bool empty()
+ *
+ * Returns: true if size() is zero
+ */
+template <typename Type, typename Hash>
+bool Concurrent_hash_table<Type, Hash>::empty() const {
+    return size() == 0;
+}
+
+/*
+ * Accessor: bool member(Type const &obj)
+ *           Probe for the bin holding obj, stopping at the first
+ *           unoccupied bin.
+ *
+ * Returns: true if obj is in the hash table
+ */
+template <typename Type, typename Hash>
+bool Concurrent_hash_table<Type, Hash>::member(Type const &obj) const {
+    word key = key_bits( obj );
+    int bin = static_cast<int>( hasher( obj ) & mask );
+
+    for ( int i = 0; i < array_size; ++i ) {
+        word current = array[bin].load();
+
+        if ( current == UNOCCUPIED ) {
+            return false;
+        } else if ( current == (OCCUPIED | key) ) {
+            return true;
+        }
+
+        bin = (bin + i + 1) & mask;
+    }
+
+    return false;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Mutators                                                    * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: bool insert(Type const &obj)
+ *         Probe from the home bin of obj for obj, noting the first
+ *         unoccupied or erased bin, and claim that bin with a
+ *         compare-and-swap.  The claim becomes an entry unless
+ *         settle() finds obj elsewhere or withdraws it in favour of
+ *         an earlier claim, in which case the insert starts again.
+ *
+ *         An exception is thrown if every bin holds or claims a key
+ *
+ * Returns: true if obj was inserted, false if it was already present
+ */
+template <typename Type, typename Hash>
+bool Concurrent_hash_table<Type, Hash>::insert(Type const &obj) {
+    word key = key_bits( obj );
+    int home = static_cast<int>( hasher( obj ) & mask );
+
+    for (;;) {
+        int bin = home;
+        int free_bin = -1;
+        int free_step = 0;
+        word free_word = 0;
+
+        for ( int i = 0; i < array_size; ++i ) {
+            word current = wait_for_claim( bin, key );
+
+            if ( current == (OCCUPIED | key) ) {
+                return false;
+            } else if ( free_bin < 0 && (current == UNOCCUPIED || (current & STATE) == ERASED) ) {
+                free_bin = bin;
+                free_step = i;
+                free_word = current;
+            }
+
+            if ( current == UNOCCUPIED ) {
+                break;
+            }
+
+            bin = (bin + i + 1) & mask;
+        }
+
+        if ( free_bin < 0 ) {
+            throw overflow();
+        }
+
+        // if another thread took the bin first, probe again
+        if ( !array[free_bin].compare_exchange_strong( free_word, CLAIMED | key ) ) {
+            continue;
+        }
+
+        switch ( settle( home, free_step, key ) ) {
+            case KEEP:
+                array[free_bin].store( OCCUPIED | key );
+                local_count().fetch_add( 1, std::memory_order_relaxed );
+                return true;
+            case DUPLICATE:
+                array[free_bin].store( ERASED );
+                return false;
+            case WITHDRAW:
+                array[free_bin].store( ERASED );
+                break;
+        }
+    }
+}
+
+/*
+ * Method: bool erase(Type const &obj)
+ *         Mark the bin holding obj as erased; any key may later
+ *         claim it.
+ *
+ * Returns: true if obj was erased by this call
+ */
+template <typename Type, typename Hash>
+bool Concurrent_hash_table<Type, Hash>::erase(Type const &obj) {
+    word key = key_bits( obj );
+    int bin = static_cast<int>( hasher( obj ) & mask );
+
+    for ( int i = 0; i < array_size; ++i ) {
+        word current = array[bin].load();
+
+        if ( current == UNOCCUPIED ) {
+            return false;
+        } else if ( current == (OCCUPIED | key) ) {
+            // only another erase of obj can make this fail
+            if ( array[bin].compare_exchange_strong( current, ERASED ) ) {
+                local_count().fetch_sub( 1, std::memory_order_relaxed );
+                return true;
+            }
+
+            return false;
+        }
+
+        bin = (bin + i + 1) & mask;
+    }
+
+    return false;
+}
+
+/*
+ * Method: void clear()
+ *         Make every bin unoccupied.  Unlike the other operations,
+ *         clear() must not run concurrently with any other call.
+ */
+template <typename Type, typename Hash>
+void Concurrent_hash_table<Type, Hash>::clear() {
+    for ( int i = 0; i < array_size; ++i ) {
+        array[i].store( UNOCCUPIED, std::memory_order_relaxed );
+    }
+
+    for ( int i = 0; i < stripes; ++i ) {
+        counts[i].value.store( 0, std::memory_order_relaxed );
+    }
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Helpers                                                     * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: word key_bits(Type const &obj)
+ *
+ * Returns: obj as the low half of a bin
+ */
+template <typename Type, typename Hash>
+typename Concurrent_hash_table<Type, Hash>::word
+Concurrent_hash_table<Type, Hash>::key_bits(Type const &obj) {
+    return static_cast<word>( static_cast<unsigned int>( obj ) );
+}
+
+/*
+ * Accessor: word wait_for_claim(int bin, word key)
+ *           Wait while another thread claims the bin for key.
+ *
+ * Returns: the contents of the bin once it is not claimed for key
+ */
+template <typename Type, typename Hash>
+typename Concurrent_hash_table<Type, Hash>::word
+Concurrent_hash_table<Type, Hash>::wait_for_claim(int bin, word key) const {
+    word current = array[bin].load();
+
+    while ( current == (CLAIMED | key) ) {
+        std::this_thread::yield();
+        current = array[bin].load();
+    }
+
+    return current;
+}
+
+/*
+ * Accessor: claim_t settle(int home, int step, word key)
+ *           Examine the probe sequence of key, from its home bin to
+ *           the first unoccupied bin, except for the bin this thread
+ *           claimed at the given step.  A claim for key in a later
+ *           bin is waited for; the thread that made it will see this
+ *           claim and withdraw, or will already have kept its own.
+ *
+ *           The claim and these loads are sequentially consistent:
+ *           of two threads claiming the same key, at least one sees
+ *           the claim of the other.
+ *
+ * Returns: DUPLICATE if another bin holds key, WITHDRAW if an earlier
+ *          bin is claimed for key and KEEP otherwise
+ */
+template <typename Type, typename Hash>
+typename Concurrent_hash_table<Type, Hash>::claim_t
+Concurrent_hash_table<Type, Hash>::settle(int home, int step, word key) const {
+    int bin = home;
+
+    for ( int i = 0; i < array_size; ++i ) {
+        if ( i != step ) {
+            word current = array[bin].load();
+
+            if ( current == (CLAIMED | key) ) {
+                if ( i < step ) {
+                    return WITHDRAW;
+                }
+
+                current = wait_for_claim( bin, key );
+            }
+
+            if ( current == (OCCUPIED | key) ) {
+                return DUPLICATE;
+            } else if ( current == UNOCCUPIED ) {
+                return KEEP;
+            }
+        }
+
+        bin = (bin + i + 1) & mask;
+    }
+
+    return KEEP;
+}
+
+/*
+ * Accessor: std::atomic<long> &local_count()
+ *
+ * Returns: the size counter used by the calling thread; threads are
+ *          assigned counters in turn the first time they need one
+ */
+template <typename Type, typename Hash>
+std::atomic<long> &Concurrent_hash_table<Type, Hash>::local_count() {
+    static std::atomic<int> next_stripe( 0 );
+    static thread_local int stripe = next_stripe.fetch_add( 1, std::memory_order_relaxed ) % stripes;
+
+    return counts[stripe].value;
+}
+
+#endif
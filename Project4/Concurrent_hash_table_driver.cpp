@@ -0,0 +1,283 @@
+/****************************************************
+ * Executable:   Concurrent_hash_table
+ * Author:  Keshav Kanatala
+ *
+ * Exercise Concurrent_hash_table from several threads.
+ *
+ *   Concurrent_hash_table stress [threads]
+ *       Each thread inserts, erases and looks up its own keys and
+ *       checks every result against a private std::set; then all
+ *       threads fight over a few shared keys and the final table is
+ *       checked against the successful inserts and erases.  Last,
+ *       the threads pass hundreds of times the capacity of a small
+ *       table in distinct keys through it, a few at a time, so that
+ *       every key reuses bins erased by others, while they keep
+ *       fighting over the shared keys.
+ *
+ *   Concurrent_hash_table bench [threads]
+ *       Run a read-mostly workload (7/8 member, 1/16 insert, 1/16 erase)
+ *       with 1, 2, ... up to the given number of threads (by default
+ *       the number of hardware threads) and report the throughput.
+ *
+ * Link with -pthread.
+ ****************************************************/
+
+#include <set>
+#include <vector>
+#include "Thread_driver.h"
+#include "Concurrent_hash_table.h"
+
+typedef Concurrent_hash_table<int, Murmur_hash<int> > table_t;
+
+/*
+ * Disjoint keys: thread t owns the keys congruent to t modulo the
+ * number of threads, so its private std::set predicts every result.
+ */
+void stress_disjoint( table_t &table, int t, int threads, int range, int ops,
+                      std::set<int> &expected, int &failures ) {
+	Random random( t );
+
+	for ( int i = 0; i < ops; ++i ) {
+		int key = static_cast<int>( random.next() % range ) * threads + t;
+		bool result;
+		bool predicted;
+
+		switch ( random.next() % 3 ) {
+			case 0:
+				result = table.insert( key );
+				predicted = expected.insert( key ).second;
+				break;
+			case 1:
+				result = table.erase( key );
+				predicted = expected.erase( key ) > 0;
+				break;
+			default:
+				result = table.member( key );
+				predicted = expected.count( key ) > 0;
+				break;
+		}
+
+		if ( result != predicted ) {
+			++failures;
+		}
+	}
+}
+
+/*
+ * Shared keys: every thread inserts and erases the same few keys and
+ * counts its successful calls per key.
+ */
+void stress_shared( table_t &table, int t, int keys, int ops,
+                    std::vector<int> &inserted, std::vector<int> &erased ) {
+	Random random( 1000 + t );
+
+	for ( int i = 0; i < ops; ++i ) {
+		int key = -1 - static_cast<int>( random.next() % keys );
+
+		if ( random.next() % 2 == 0 ) {
+			inserted[-1 - key] += table.insert( key );
+		} else {
+			erased[-1 - key] += table.erase( key );
+		}
+	}
+}
+
+/*
+ * Churn: thread t inserts its keys t, t + threads, t + 2 threads, ...
+ * in turn and erases each one again window keys later.  Between them
+ * it inserts or erases one of the shared keys, counting its successful
+ * calls per key as stress_shared() does.
+ */
+void stress_churn( table_t &table, int t, int threads, int window, int keys, int shared_keys,
+                   std::vector<int> &inserted, std::vector<int> &erased, int &failures ) {
+	Random random( 2000 + t );
+
+	try {
+		for ( int k = 0; k < keys; ++k ) {
+			int key = k * threads + t;
+
+			failures += !table.insert( key );
+
+			if ( k >= window ) {
+				int old = key - window * threads;
+
+				failures += !table.member( old ) + !table.erase( old ) + table.member( old );
+			}
+
+			int shared = -1 - static_cast<int>( random.next() % shared_keys );
+
+			if ( random.next() % 2 == 0 ) {
+				inserted[-1 - shared] += table.insert( shared );
+			} else {
+				erased[-1 - shared] += table.erase( shared );
+			}
+		}
+	} catch ( overflow ) {
+		std::cout << "Failure in insert(): the table overflowed with " << table.size() << " entries" << std::endl;
+		++failures;
+	}
+}
+
+/*
+ * Check the shared keys against the successful inserts and erases of
+ * every thread.
+ *
+ * Returns: the number of errors; total is increased by the number of
+ *          shared keys in the table
+ */
+int check_shared( table_t const &table, int threads, int shared_keys, std::vector<std::vector<int> > const &inserted,
+                  std::vector<std::vector<int> > const &erased, int &total ) {
+	int errors = 0;
+
+	for ( int key = 0; key < shared_keys; ++key ) {
+		int net = 0;
+
+		for ( int t = 0; t < threads; ++t ) {
+			net += inserted[t][key] - erased[t][key];
+		}
+
+		// successful inserts and erases of a key must alternate
+		if ( !(net == 0 || net == 1) || table.member( -1 - key ) != (net == 1) ) {
+			++errors;
+		}
+
+		total += net;
+	}
+
+	return errors;
+}
+
+int stress( int threads ) {
+	int const range = 4096;
+	int const ops = 400000;
+	int const shared_keys = 64;
+	int const churn_shared_keys = 8;
+
+	table_t table( 20 );
+	std::vector<std::set<int> > expected( threads );
+	std::vector<int> failures( threads, 0 );
+
+	run_threads( threads, [&]( int t ) {
+		stress_disjoint( table, t, threads, range, ops, expected[t], failures[t] );
+	} );
+
+	int errors = 0;
+	int total = 0;
+
+	for ( int t = 0; t < threads; ++t ) {
+		errors += failures[t];
+		total += static_cast<int>( expected[t].size() );
+
+		for ( int key = 0; key < range; ++key ) {
+			if ( table.member( key * threads + t ) != (expected[t].count( key * threads + t ) > 0) ) {
+				++errors;
+			}
+		}
+	}
+
+	if ( table.size() != total ) {
+		std::cout << "Failure in size(): expecting " << total << " but got " << table.size() << std::endl;
+		++errors;
+	}
+
+	std::cout << "disjoint keys: " << threads << " threads, " << errors << " errors" << std::endl;
+
+	std::vector<std::vector<int> > inserted( threads, std::vector<int>( shared_keys, 0 ) );
+	std::vector<std::vector<int> > erased( threads, std::vector<int>( shared_keys, 0 ) );
+
+	run_threads( threads, [&]( int t ) {
+		stress_shared( table, t, shared_keys, ops, inserted[t], erased[t] );
+	} );
+
+	int shared_errors = check_shared( table, threads, shared_keys, inserted, erased, total );
+
+	if ( table.size() != total ) {
+		std::cout << "Failure in size(): expecting " << total << " but got " << table.size() << std::endl;
+		++shared_errors;
+	}
+
+	std::cout << "shared keys:   " << threads << " threads, " << shared_errors << " errors" << std::endl;
+
+	// 2^8 bins, and every thread passes 2^15 distinct keys through them
+	table_t small( 8 );
+	int const window = 16;
+	int const churned = 1 << 15;
+
+	inserted.assign( threads, std::vector<int>( churn_shared_keys, 0 ) );
+	erased.assign( threads, std::vector<int>( churn_shared_keys, 0 ) );
+	failures.assign( threads, 0 );
+
+	run_threads( threads, [&]( int t ) {
+		stress_churn( small, t, threads, window, churned, churn_shared_keys, inserted[t], erased[t], failures[t] );
+	} );
+
+	int churn_errors = 0;
+	int churn_total = threads * window;
+
+	for ( int t = 0; t < threads; ++t ) {
+		churn_errors += failures[t];
+
+		for ( int k = churned - window; k < churned; ++k ) {
+			churn_errors += !small.member( k * threads + t );
+		}
+	}
+
+	churn_errors += check_shared( small, threads, churn_shared_keys, inserted, erased, churn_total );
+
+	if ( small.size() != churn_total ) {
+		std::cout << "Failure in size(): expecting " << churn_total << " but got " << small.size() << std::endl;
+		++churn_errors;
+	}
+
+	std::cout << "churned keys:  " << threads << " threads, " << threads * churned << " keys through "
+	          << small.capacity() << " bins, " << churn_errors << " errors" << std::endl;
+
+	return errors + shared_errors + churn_errors;
+}
+
+void bench_worker( table_t &table, int t, int range, int ops, long &hits ) {
+	Random random( t );
+	long found = 0;
+
+	for ( int i = 0; i < ops; ++i ) {
+		unsigned int r = random.next();
+		int key = static_cast<int>( r % range );
+
+		switch ( r >> 28 ) {
+			case 0:
+				table.insert( key );
+				break;
+			case 1:
+				table.erase( key );
+				break;
+			default:
+				found += table.member( key );
+				break;
+		}
+	}
+
+	hits = found;
+}
+
+void bench( int max_threads ) {
+	int const power = 22;
+	int const range = 1 << (power - 1);
+	int const ops = 4000000;
+
+	table_t table( power );
+	std::vector<long> hits( max_threads, 0 );
+
+	for ( int key = 0; key < range; key += 2 ) {
+		table.insert( key );
+	}
+
+	bench_threads( "threads", max_threads, ops, [&]( int threads ) {
+		run_threads( threads, [&]( int t ) {
+			bench_worker( table, t, range, ops, hits[t] );
+		} );
+	} );
+}
+
+int main( int argc, char *argv[] ) {
+	return thread_driver( argc, argv, stress, bench );
+}
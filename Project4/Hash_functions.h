@@ -0,0 +1,215 @@
+/*****************************************
+ * Hash functions for Quadratic_hash_table
+ *
+ * Keshav Kanatala
+ *
+ * A hash function object maps an entry to a std::size_t hash code.
+ * The table takes the home bin from the low bits of the code (code
+ * & mask) and the control tag from a mix of the whole code, so a
+ * hash function must spread its input over the low bits.
+ *
+ * Every hash function here can be constructed with a seed, which is
+ * returned by seed() so that a table image can record it, and has a
+ * distinct static const int id, which the image records so that it is
+ * not probed with a different function.
+ *
+ *   Identity_hash<Type>    the value itself, as the original hash()
+ *   Fibonacci_hash<Type>   multiply by 2^64/phi, keep the high half
+ *   Murmur_hash<Type>      the 64-bit MurmurHash3 finalizer
+ *   Float_hash<Type>       the bit pattern of a float or double,
+ *                          with -0.0 and every NaN canonicalized
+ *   Default_hash<Type>     Float_hash for floating-point types and
+ *                          Identity_hash otherwise
+ *****************************************/
+
+#ifndef HASH_FUNCTIONS_H
+#define HASH_FUNCTIONS_H
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Function: unsigned long long murmur_mix(unsigned long long x)
+ *
+ * Returns: x passed through the MurmurHash3 64-bit finalizer; every
+ *          input bit affects every output bit
+ */
+inline unsigned long long murmur_mix( unsigned long long x ) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+/*
+ * Function: int scattered_key(long i)
+ *
+ * Returns: the i-th key of a sequence scattered over the whole range
+ *          of int, i times Knuth's multiplier 2654435761 modulo 2^32;
+ *          the keys are distinct for distinct i below 2^32
+ */
+inline int scattered_key( long i ) {
+    return static_cast<int>( static_cast<unsigned int>( i ) * 2654435761u );
+}
+
+/*
+ * Identity_hash<Type>
+ *
+ * The integer value of the entry (xor the seed).  Consecutive keys
+ * land in consecutive bins, which matches the placement of the
+ * original hash() but clusters badly with strided keys.
+ */
+template <typename Type>
+class Identity_hash {
+private:
+    std::size_t salt;
+
+public:
+    static const int id = 1;
+
+    explicit Identity_hash( std::size_t s = 0 ):
+    salt( s ) {
+        // empty constructor
+    }
+
+    std::size_t seed() const {
+        return salt;
+    }
+
+    std::size_t operator()( Type const &obj ) const {
+        return static_cast<std::size_t>( static_cast<long long>( obj ) ) ^ salt;
+    }
+};
+
+/*
+ * Fibonacci_hash<Type>
+ *
+ * Multiplicative hashing by 2^64/phi.  The high half of the product
+ * depends on every input bit, so the halves are swapped: the bins
+ * come from the high bits and the tag from the rest.
+ */
+template <typename Type>
+class Fibonacci_hash {
+private:
+    std::size_t salt;
+
+public:
+    static const int id = 2;
+
+    explicit Fibonacci_hash( std::size_t s = 0 ):
+    salt( s ) {
+        // empty constructor
+    }
+
+    std::size_t seed() const {
+        return salt;
+    }
+
+    std::size_t operator()( Type const &obj ) const {
+        unsigned long long x = static_cast<unsigned long long>( static_cast<long long>( obj ) ) ^ salt;
+        unsigned long long product = x * 0x9E3779B97F4A7C15ULL;
+
+        return static_cast<std::size_t>( (product >> 32) | (product << 32) );
+    }
+};
+
+/*
+ * Murmur_hash<Type>
+ *
+ * The MurmurHash3 finalizer applied to the integer value of the
+ * entry.  Slower than Fibonacci_hash but with full avalanche.
+ */
+template <typename Type>
+class Murmur_hash {
+private:
+    std::size_t salt;
+
+public:
+    static const int id = 3;
+
+    explicit Murmur_hash( std::size_t s = 0 ):
+    salt( s ) {
+        // empty constructor
+    }
+
+    std::size_t seed() const {
+        return salt;
+    }
+
+    std::size_t operator()( Type const &obj ) const {
+        unsigned long long x = static_cast<unsigned long long>( static_cast<long long>( obj ) );
+
+        return static_cast<std::size_t>( murmur_mix( x ^ salt ) );
+    }
+};
+
+/*
+ * Float_hash<Type>
+ *
+ * Hashes the bit pattern of a float or double rather than its
+ * truncated integer value, so keys in [0, 1) do not all share a bin.
+ * Values that compare equal hash equally: -0.0 is hashed as 0.0.
+ * NaN never compares equal, but every NaN is hashed alike so they
+ * do not scatter.
+ */
+template <typename Type>
+class Float_hash {
+private:
+    std::size_t salt;
+
+public:
+    static const int id = 4;
+
+    explicit Float_hash( std::size_t s = 0 ):
+    salt( s ) {
+        // empty constructor
+    }
+
+    std::size_t seed() const {
+        return salt;
+    }
+
+    std::size_t operator()( Type const &obj ) const {
+        double value = static_cast<double>( obj );
+        unsigned long long bits;
+
+        if ( value == 0.0 ) {
+            value = 0.0;
+        } else if ( value != value ) {
+            return static_cast<std::size_t>( murmur_mix( 0x7FF8000000000000ULL ^ salt ) );
+        }
+
+        std::memcpy( &bits, &value, sizeof( bits ) );
+
+        return static_cast<std::size_t>( murmur_mix( bits ^ salt ) );
+    }
+};
+
+/*
+ * Default_hash<Type>
+ *
+ * The hash function used when none is given.
+ */
+template <typename Type, bool Floating = std::is_floating_point<Type>::value>
+class Default_hash:public Identity_hash<Type> {
+public:
+    explicit Default_hash( std::size_t s = 0 ):
+    Identity_hash<Type>( s ) {
+        // empty constructor
+    }
+};
+
+template <typename Type>
+class Default_hash<Type, true>:public Float_hash<Type> {
+public:
+    explicit Default_hash( std::size_t s = 0 ):
+    Float_hash<Type>( s ) {
+        // empty constructor
+    }
+};
+
+#endif
@@ -0,0 +1,311 @@
+/*****************************************
+ * Probe policies for Quadratic_hash_table
+ *
+ * Keshav Kanatala
+ *
+ * Every bin of the hash table has a one-byte control entry stored
+ * in a separate array.  The top bit of the control byte is set for
+ * bins that hold no entry; an occupied bin stores seven bits of the
+ * hash code of its entry (its tag), so most mismatches are rejected
+ * without touching the array of entries.
+ *
+ * A probe policy describes how many control bytes are examined at
+ * once (its width) and the order in which the table visits groups
+ * of that many bins.  A policy provides
+ *
+ *   static const int width     the number of bins in a group (1 or 16)
+ *   static const int id        distinct for each policy, recorded in
+ *                              a table image
+ *   class sequence             constructed from the home group, the
+ *                              hash code and the mask of the group
+ *                              count; position() is the current group
+ *                              and next() advances to the next one
+ *
+ * Every sequence here wraps with the mask and visits each group of a
+ * power-of-two table exactly once, so a probe can stop as soon as it
+ * reaches a group with an unoccupied bin or has seen every group.
+ *****************************************/
+
+#ifndef PROBE_POLICIES_H
+#define PROBE_POLICIES_H
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PROBE_POLICIES_SSE2
+#endif
+
+// control byte values of bins without an entry
+const unsigned char CONTROL_UNOCCUPIED = 0x80;
+const unsigned char CONTROL_ERASED     = 0xFE;
+const unsigned char CONTROL_REHASHING  = 0xFD;  // transient, see compact()
+const unsigned char CONTROL_SENTINEL   = 0xFF;  // padding past the last bin
+
+/*
+ * Function: unsigned char control_tag(std::size_t code)
+ *
+ * Returns: the seven bits of the hash code stored in the control
+ *          byte of an occupied bin.  The code is mixed first so that
+ *          the tag does not repeat the bits that select the bin.
+ */
+inline unsigned char control_tag( std::size_t code ) {
+    unsigned long long mixed = static_cast<unsigned long long>( code ) * 0x9E3779B97F4A7C15ULL;
+
+    return static_cast<unsigned char>( mixed >> 57 );
+}
+
+/*
+ * Function: int lowest_bit(unsigned bits)
+ *
+ * Returns: the index of the lowest set bit of a non-zero mask
+ */
+inline int lowest_bit( unsigned bits ) {
+    return __builtin_ctz( bits );
+}
+
+/*
+ * Function: int lowest_bit64(unsigned long long bits)
+ *
+ * Returns: the index of the lowest set bit of a non-zero mask
+ */
+inline int lowest_bit64( unsigned long long bits ) {
+    return __builtin_ctzll( bits );
+}
+
+/*
+ * Function: unsigned long long occupied_bits(unsigned char const *ctrl, int n)
+ *
+ * Returns: a mask with bit i set if the i-th of the n <= 64 control
+ *          bytes at ctrl belongs to an occupied bin (its top bit is
+ *          clear); a full word is built with four SSE2 loads
+ */
+inline unsigned long long occupied_bits( unsigned char const *ctrl, int n ) {
+#ifdef PROBE_POLICIES_SSE2
+    if ( n == 64 ) {
+        unsigned long long unoccupied = 0;
+
+        for ( int i = 0; i < 4; ++i ) {
+            __m128i bytes = _mm_loadu_si128( reinterpret_cast<__m128i const *>( ctrl + 16 * i ) );
+
+            unoccupied |= static_cast<unsigned long long>( static_cast<unsigned>( _mm_movemask_epi8( bytes ) ) ) << (16 * i);
+        }
+
+        return ~unoccupied;
+    }
+#endif
+
+    unsigned long long bits = 0;
+
+    for ( int i = 0; i < n; ++i ) {
+        if ( ctrl[i] < CONTROL_UNOCCUPIED ) {
+            bits |= 1ULL << i;
+        }
+    }
+
+    return bits;
+}
+
+/*
+ * Function: void prefetch_address(void const *ptr)
+ *           Hint that the cache line holding ptr will be read soon.
+ *           This is a no-op for compilers without __builtin_prefetch.
+ */
+inline void prefetch_address( void const *ptr ) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch( ptr );
+#else
+    (void)ptr;
+#endif
+}
+
+/*
+ * Control_group<width>
+ *
+ * A view of 'width' consecutive control bytes.  match(c) returns a
+ * bit mask with bit i set if the i-th control byte equals c.
+ */
+template <int Width>
+class Control_group;
+
+template <>
+class Control_group<1> {
+private:
+    unsigned char control;
+
+public:
+    explicit Control_group( unsigned char const *ptr ):
+    control( *ptr ) {
+        // empty constructor
+    }
+
+    unsigned match( unsigned char c ) const {
+        return control == c;
+    }
+};
+
+template <>
+class Control_group<16> {
+private:
+#ifdef PROBE_POLICIES_SSE2
+    __m128i control;
+#else
+    unsigned char const *control;
+#endif
+
+public:
+    explicit Control_group( unsigned char const *ptr ):
+#ifdef PROBE_POLICIES_SSE2
+    control( _mm_loadu_si128( reinterpret_cast<__m128i const *>( ptr ) ) ) {
+#else
+    control( ptr ) {
+#endif
+        // empty constructor
+    }
+
+    unsigned match( unsigned char c ) const {
+#ifdef PROBE_POLICIES_SSE2
+        __m128i pattern = _mm_set1_epi8( static_cast<char>( c ) );
+
+        return static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( control, pattern ) ) );
+#else
+        unsigned bits = 0;
+
+        for ( int i = 0; i < 16; ++i ) {
+            if ( control[i] == c ) {
+                bits |= 1u << i;
+            }
+        }
+
+        return bits;
+#endif
+    }
+};
+
+/*
+ * Quadratic_probe
+ *
+ * Examines one bin at a time, visiting home, home + 1, home + 3,
+ * home + 6, ... (offsets are the triangular numbers), which reaches
+ * every bin of a power-of-two table exactly once.
+ */
+class Quadratic_probe {
+public:
+    static const int width = 1;
+    static const int id = 1;
+
+    class sequence {
+    private:
+        int current;
+        int offset;
+        int mask;
+
+    public:
+        sequence( int home, std::size_t, int m ):
+        current( home ),
+        offset( 0 ),
+        mask( m ) {
+            // empty constructor
+        }
+
+        int position() const {
+            return current;
+        }
+
+        void next() {
+            current = (current + ++offset) & mask;
+        }
+    };
+};
+
+/*
+ * Linear_probe
+ *
+ * Examines one bin at a time, visiting home, home + 1, home + 2, ...
+ * Consecutive probes touch adjacent bins, which is the most cache
+ * friendly order but lets clusters of occupied bins merge.
+ */
+class Linear_probe {
+public:
+    static const int width = 1;
+    static const int id = 2;
+
+    class sequence {
+    private:
+        int current;
+        int mask;
+
+    public:
+        sequence( int home, std::size_t, int m ):
+        current( home ),
+        mask( m ) {
+            // empty constructor
+        }
+
+        int position() const {
+            return current;
+        }
+
+        void next() {
+            current = (current + 1) & mask;
+        }
+    };
+};
+
+/*
+ * Double_hash_probe
+ *
+ * Examines one bin at a time, visiting home, home + s, home + 2s, ...
+ * where the step s is drawn from bits of the hash code that do not
+ * select the home bin.  The step is odd, so it is coprime with the
+ * power-of-two table size and every bin is reached.  Entries that
+ * share a home bin follow different sequences.
+ */
+class Double_hash_probe {
+public:
+    static const int width = 1;
+    static const int id = 3;
+
+    class sequence {
+    private:
+        int current;
+        int stride;
+        int mask;
+
+    public:
+        sequence( int home, std::size_t code, int m ):
+        current( home ),
+        stride( static_cast<int>( (static_cast<unsigned long long>( code ) * 0xC2B2AE3D27D4EB4FULL) >> 34 ) | 1 ),
+        mask( m ) {
+            // empty constructor
+        }
+
+        int position() const {
+            return current;
+        }
+
+        void next() {
+            current = (current + stride) & mask;
+        }
+    };
+};
+
+/*
+ * Group_probe<Probe>
+ *
+ * Examines sixteen bins at a time (with SSE2 where available), and
+ * visits the aligned groups of sixteen bins in the order given by
+ * the sequence of Probe (any of the policies above).  Only bins
+ * whose tag matches are compared, and the search stops at the first
+ * group with an unoccupied bin.
+ */
+template <typename Probe = Quadratic_probe>
+class Group_probe {
+public:
+    static const int width = 16;
+    static const int id = 16 + Probe::id;
+
+    typedef typename Probe::sequence sequence;
+};
+
+#endif
@@ -0,0 +1,263 @@
+/*****************************************
+ * Quadratic_hash_map
+ *
+ * Keshav Kanatala
+ *
+ * A map from keys to values built on the open-addressing engine of
+ * Quadratic_hash_table: the same control bytes, probe policies, hash
+ * functions, incremental resizing and compaction.
+ *
+ * Each bin holds a Map_entry, the key followed by its value, so a
+ * successful lookup reads the value from the bin whose key it has
+ * just compared instead of from a separate node.
+ *****************************************/
+
+#ifndef QUADRATIC_HASH_MAP_H
+#define QUADRATIC_HASH_MAP_H
+
+#include "Quadratic_hash_table.h"
+
+#include <utility>
+
+/*
+ * Map_entry<Key, Value>
+ *
+ * The contents of one bin of a Quadratic_hash_map.  An entry compares
+ * equal to a key, which lets the table probe for a key directly.
+ * Entries are only ever constructed in place, from a key and the
+ * arguments of the value.
+ */
+template <typename Key, typename Value>
+class Map_entry {
+public:
+    Key key;
+    Value value;
+
+    template <typename... Args>
+    explicit Map_entry( Key const &k, Args&&... args ):
+    key( k ),
+    value( std::forward<Args>( args )... ) {
+        // empty constructor
+    }
+};
+
+template <typename Key, typename Value>
+bool operator==( Map_entry<Key, Value> const &entry, Key const &key ) {
+    return entry.key == key;
+}
+
+template <typename Key, typename Value>
+std::ostream &operator<<( std::ostream &out, Map_entry<Key, Value> const &entry ) {
+    return out << entry.key << ':' << entry.value;
+}
+
+/*
+ * Map_entry_hash<Key, Value, Hash>
+ *
+ * Hashes a key with Hash and an entry by its key, so that the table
+ * finds the same bins whether it is given an entry or a key.
+ */
+template <typename Key, typename Value, typename Hash>
+class Map_entry_hash:public Hash {
+public:
+    explicit Map_entry_hash( Hash const &h = Hash() ):
+    Hash( h ) {
+        // empty constructor
+    }
+
+    using Hash::operator();
+
+    std::size_t operator()( Map_entry<Key, Value> const &entry ) const {
+        return Hash::operator()( entry.key );
+    }
+};
+
+/*
+ * Quadratic_hash_map class
+ *
+ * Unlike Quadratic_hash_table, the map resizes by default: its
+ * maximum load factor starts at 0.75.  Every operation probes the
+ * table once; in particular try_emplace(), insert_or_assign() and
+ * operator[] find the key and the bin to insert it into in the same
+ * pass.
+ *
+ * Pointers returned by find(), try_emplace() and operator[] are
+ * invalidated by any later insertion, erasure or lookup, since these
+ * may resize, compact or migrate the table.
+ */
+template <typename Key, typename Value, typename Probe = Quadratic_probe, typename Hash = Default_hash<Key> >
+class Quadratic_hash_map:private Quadratic_hash_table<Map_entry<Key, Value>, Probe, Map_entry_hash<Key, Value, Hash> > {
+private:
+    typedef Map_entry<Key, Value> entry;
+    typedef Quadratic_hash_table<entry, Probe, Map_entry_hash<Key, Value, Hash> > table;
+
+public:
+    // constructors
+    Quadratic_hash_map();
+    Quadratic_hash_map(int m, Hash const &h = Hash());
+
+    // accessors
+    using table::size;
+    using table::capacity;
+    using table::load_factor;
+    using table::empty;
+    using table::max_load_factor;
+    using table::resizing;
+    using table::max_erased_ratio;
+    using table::compactions;
+    using table::reclaimed;
+
+    bool member(Key const &key) const;
+    Value *find(Key const &key);
+    Value const *find(Key const &key) const;
+
+    // mutators
+    template <typename... Args>
+    std::pair<Value *, bool> try_emplace(Key const &key, Args&&... args);
+    bool insert_or_assign(Key const &key, Value const &value);
+    Value &operator[](Key const &key);
+    bool erase(Key const &key);
+
+    using table::clear;
+    using table::compact;
+};
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Constructors                                                * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Constructor: Quadratic_hash_map()
+ *
+ * Creates a new hash map with an initial capacity of 2^5
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+Quadratic_hash_map<Key, Value, Probe, Hash>::Quadratic_hash_map():
+table() {
+    table::max_load_factor( 0.75 );
+}
+
+/*
+ * Constructor: Quadratic_hash_map(int n, Hash const &h)
+ *
+ * Creates a new hash map with an initial capacity of 2^n that
+ * hashes its keys with h
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+Quadratic_hash_map<Key, Value, Probe, Hash>::Quadratic_hash_map(int n, Hash const &h):
+table( n, Map_entry_hash<Key, Value, Hash>( h ) ) {
+    table::max_load_factor( 0.75 );
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Accessors                                                   * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: bool member(Key const &key)
+ *
+ * Returns: true if the map has an entry for key
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+bool Quadratic_hash_map<Key, Value, Probe, Hash>::member(Key const &key) const {
+    return table::lookup( key ) != nullptr;
+}
+
+/*
+ * Accessor: Value *find(Key const &key)
+ *
+ * Returns: a pointer to the value of key, or nullptr if there is none
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+Value *Quadratic_hash_map<Key, Value, Probe, Hash>::find(Key const &key) {
+    entry *slot = table::lookup( key );
+
+    return (slot == nullptr) ? nullptr : &slot->value;
+}
+
+template <typename Key, typename Value, typename Probe, typename Hash>
+Value const *Quadratic_hash_map<Key, Value, Probe, Hash>::find(Key const &key) const {
+    entry const *slot = table::lookup( key );
+
+    return (slot == nullptr) ? nullptr : &slot->value;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Mutators                                                    * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: std::pair<Value *, bool> try_emplace(Key const &key, Args&&... args)
+ *         If key is absent, insert it with the value constructed
+ *         from args; otherwise leave the existing value (and args)
+ *         untouched.
+ *
+ * Returns: a pointer to the value of key and whether it was inserted
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+template <typename... Args>
+std::pair<Value *, bool> Quadratic_hash_map<Key, Value, Probe, Hash>::try_emplace(Key const &key, Args&&... args) {
+    bool inserted;
+    entry *slot = table::claim( key, inserted );
+
+    if ( inserted ) {
+        table::construct( slot, key, std::forward<Args>( args )... );
+    }
+
+    return std::make_pair( &slot->value, inserted );
+}
+
+/*
+ * Method: bool insert_or_assign(Key const &key, Value const &value)
+ *         Set the value of key, inserting key if it is absent.
+ *
+ * Returns: true if key was inserted, false if it was assigned
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+bool Quadratic_hash_map<Key, Value, Probe, Hash>::insert_or_assign(Key const &key, Value const &value) {
+    bool inserted;
+    entry *slot = table::claim( key, inserted );
+
+    if ( inserted ) {
+        table::construct( slot, key, value );
+    } else {
+        slot->value = value;
+    }
+
+    return inserted;
+}
+
+/*
+ * Method: Value &operator[](Key const &key)
+ *
+ * Returns: the value of key, inserting a value-initialized one first
+ *          if key is absent
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+Value &Quadratic_hash_map<Key, Value, Probe, Hash>::operator[](Key const &key) {
+    return *try_emplace( key ).first;
+}
+
+/*
+ * Method: bool erase(Key const &key)
+ *
+ * Returns: true if the entry for key is deleted from the map
+ */
+template <typename Key, typename Value, typename Probe, typename Hash>
+bool Quadratic_hash_map<Key, Value, Probe, Hash>::erase(Key const &key) {
+    return table::remove( key );
+}
+
+#endif
@@ -26,16 +26,83 @@
 #ifndef DOUBLE_HASH_TABLE_H
 #define DOUBLE_HASH_TABLE_H
 
+// the nullptr macro below (or one defined by an earlier header) must
+// not replace the keyword inside the standard headers
+#pragma push_macro("nullptr")
+#undef nullptr
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#pragma pop_macro("nullptr")
+
 #ifndef nullptr
 #define nullptr 0
 #endif
 
 #include "exception.h"
 #include "ece250.h"
+#include "Probe_policies.h"
+#include "Hash_functions.h"
+#include "Table_image.h"
+#include "Allocators.h"
 
 // enum to track bins status
 enum bin_state_t { UNOCCUPIED, OCCUPIED, ERASED };
 
+/*
+ * Quadratic_hash_table_stats
+ *
+ * What Quadratic_hash_table::stats() reports.  A probe is one group
+ * examined (one bin unless the probe policy compares groups of bins).
+ *
+ * The structure of the table is scanned on every call.  The runtime
+ * counters are kept only when QUADRATIC_HASH_TABLE_STATS is defined
+ * before the table is included (counted is then true); otherwise
+ * they are compiled out and stay zero.
+ */
+struct Quadratic_hash_table_stats {
+    static const int CLUSTER_BUCKETS = 31;
+
+    // structure
+    int size;                           // number of entries
+    int capacity;                       // number of bins
+    int erased;                         // number of erased bins (tombstones)
+    double load_factor;                 // (size + erased) / capacity, as load_factor()
+    double tombstone_ratio;             // erased / capacity
+    unsigned long long array_bytes;     // bytes of the entry array
+    unsigned long long control_bytes;   // bytes of the control bytes
+    int home_collisions;                // entries whose home bin, hash(), is also
+                                        // the home of an entry in a lower bin (the
+                                        // entries less the distinct home bins)
+    double mean_hit_probes;             // probes to find an entry, on average
+    int max_hit_probes;                 // ... and at most
+    double mean_miss_probes;            // probes to miss from each home group
+    int max_miss_probes;                // ... and at most
+    int max_cluster;                    // longest run of bins that are not unoccupied
+    int clusters[CLUSTER_BUCKETS];      // runs of length [2^i, 2^(i + 1))
+
+    // runtime counters
+    bool counted;                       // whether the counters were compiled in
+    unsigned long long lookups;         // searches for a key
+    unsigned long long hits;            // ... that found it
+    unsigned long long hit_probes;      // probes made by hits
+    unsigned long long miss_probes;     // probes made by misses
+    unsigned long long insertions;      // entries inserted
+    unsigned long long erasures;        // entries erased
+
+    Quadratic_hash_table_stats() {
+        std::memset(this, 0, sizeof(*this));
+    }
+};
+
 /*
  * Quadratic_hash_table class
  *
@@ -47,28 +114,111 @@ enum bin_state_t { UNOCCUPIED, OCCUPIED, ERASED };
  * The default capacity of the hash table is 32, unless explicitly
  * mentioned in the constructor.
  *
- * The hash table cannot be resized.
+ * The state of each bin is kept in a one-byte control entry that
+ * also holds seven bits of the hash of its entry (see Probe_policies.h),
+ * so a probe only compares entries whose tag matches.  The second
+ * template argument selects how bins are probed:
+ *
+ *   Quadratic_probe       triangular offsets home + i(i+1)/2 (default)
+ *   Linear_probe          consecutive bins
+ *   Double_hash_probe     a fixed odd step taken from the hash code
+ *   Group_probe<P>        sixteen control bytes at a time with SSE2,
+ *                         visiting groups in the order of P
+ *
+ * Every probe wraps with the mask and stops at the first unoccupied
+ * bin, so a miss costs the length of its cluster, not the capacity.
+ *
+ * The third template argument is the hash function object (see
+ * Hash_functions.h).  The default hashes integers by their value, as
+ * before, and floating-point keys by their bit pattern; the home bin
+ * is the hash code masked to the capacity.
+ *
+ * By default the hash table is not resized: insert() throws overflow
+ * once it is full.  Setting max_load_factor() below 1 makes the table
+ * double its capacity when the load factor would cross that threshold.
+ * The entries are then migrated a few bins at a time on each subsequent
+ * insert(), erase() and member() call; until the migration finishes,
+ * lookups check both the old and the new arrays.
+ *
+ * Erased bins are left as tombstones.  compact() rehashes the entries
+ * in place, turning every tombstone back into an unoccupied bin; this
+ * happens automatically once the erased bins exceed max_erased_ratio()
+ * of the capacity.
+ *
+ * The array is raw storage: an entry is constructed in its bin when
+ * it is inserted and destroyed when it is erased, so no Type is built
+ * for a bin that never holds one.  The storage of the array and of
+ * the control bytes comes from the Alloc argument (see Allocators.h).
+ *
+ * member_batch(), insert_batch() and erase_batch() take an array of
+ * keys and report per key in a bitmap.  They hash a block of keys and
+ * prefetch their home bins before probing any of them.
+ *
+ * build() replaces the contents with a range of keys, sizing the table
+ * for them and filling disjoint regions of the array in parallel.
+ *
+ * stats() scans the table for probe lengths, clusters of occupied
+ * and erased bins and collisions on home bins.  Defining
+ * QUADRATIC_HASH_TABLE_STATS adds runtime counters of lookups, probes,
+ * insertions and erasures; without it they are not compiled.
+ *
+ * save() writes an image of the table (see Table_image.h) that
+ * Quadratic_hash_table_image maps into memory and probes in place.
+ *
+ * begin() and end() iterate over the entries in bin order.  The
+ * iterator reads the control bytes 64 bins at a time as a bitmap of
+ * occupied bins and jumps from one set bit to the next, so empty and
+ * erased runs cost one word per 64 bins rather than a step per bin.
  *
  */
-template <typename Type>
+template <typename Type, typename Probe, typename Hash>
+class Quadratic_hash_table_image;
+
+template <typename Type, typename Probe = Quadratic_probe, typename Hash = Default_hash<Type>,
+          typename Alloc = std::allocator<Type> >
 class Quadratic_hash_table {
     
     // member variables
 private:
+    typedef Control_group<Probe::width> group;
+    typedef std::allocator_traits<Alloc> entry_traits;
+    typedef typename entry_traits::template rebind_alloc<unsigned char> control_allocator;
+    typedef std::allocator_traits<control_allocator> control_traits;
+    
     const int m = 5;			// default array size
     int count;					// number of elements in the hash
     int power;					// default left shift parameter
     int array_size;				// array size of the hash table
     int mask;                   //
     int erased;                 // counter for erased bins
+    Hash hasher;                // hash function object
+    mutable Alloc allocator;    // source of the arrays
     Type *array;                // hash table array
-    bin_state_t *occupied;      // hash table bin status
+    unsigned char *control;     // hash table bin status and tags
+    
+    const int step = 8;         // bins migrated per operation while resizing
+    double max_load;            // load factor that triggers a resize
+    mutable int old_size;       // array size of the table being migrated
+    mutable int migrated;       // next bin of the old array to migrate
+    mutable Type *old_array;    // old hash table array (nullptr if idle)
+    mutable unsigned char *old_control; // old hash table bin status
+    
+    double max_erased;          // erased fraction that triggers compaction
+    int n_compactions;          // number of compactions performed
+    int n_reclaimed;            // bins reclaimed by the last compaction
+    
+#ifdef QUADRATIC_HASH_TABLE_STATS
+    mutable Quadratic_hash_table_stats counters; // runtime counters only
+#endif
     
     // member functions
 public:
+    class const_iterator;
+    typedef const_iterator iterator;
+    
     //constructors
     Quadratic_hash_table();
-    Quadratic_hash_table(int m);
+    Quadratic_hash_table(int m, Hash const &h = Hash(), Alloc const &a = Alloc());
     ~Quadratic_hash_table();
     
     // accessors
@@ -78,19 +228,178 @@ public:
     bool empty() const;
     bool member(Type const &obj) const;
     int hash( Type const &obj ) const;
+    Hash hash_function() const;
+    Alloc get_allocator() const;
     Type bin(int n) const;
+    bin_state_t state(int n) const;
     void print() const;
+    double max_load_factor() const;
+    bool resizing() const;
+    double max_erased_ratio() const;
+    int compactions() const;
+    int reclaimed() const;
+    Quadratic_hash_table_stats stats() const;
+    int member_batch(Type const *objs, int n, unsigned long long *found) const;
+    bool save(char const *path) const;
+    const_iterator begin() const;
+    const_iterator end() const;
     
     // mutators
     void insert(Type const &obj);
+    void insert(Type &&obj);
+    template <typename... Args> void emplace(Args&&... args);
     bool erase(Type const &obj);
     void clear();
+    void max_load_factor(double load);
+    void max_erased_ratio(double ratio);
+    int compact();
+    int insert_batch(Type const *objs, int n, unsigned long long *inserted);
+    int erase_batch(Type const *objs, int n, unsigned long long *erased_objs);
+    template <typename Iterator> void build(Iterator first, Iterator last, int threads = 0);
+    
+protected:
+    // lookups by any key that hashes and compares like an entry
+    template <typename Key> Type *lookup(Key const &key) const;
+    template <typename Key> Type *claim(Key const &key, bool &inserted);
+    template <typename Key> bool remove(Key const &key);
+    template <typename Key> Type *lookup(Key const &key, std::size_t code) const;
+    template <typename Key> Type *claim(Key const &key, std::size_t code, bool &inserted);
+    template <typename Key> bool remove(Key const &key, std::size_t code);
+    template <typename... Args> void construct(Type *slot, Args&&... args);
+    
+private:
+    // storage helpers
+    Type *new_array(int size) const;
+    void delete_array(Type *arr, unsigned char const *ctrl, int size) const;
+    static void destroy(Type *arr, unsigned char const *ctrl, int size);
     
+
+    // probing helpers
+    static const int batch = 16;    // keys hashed and prefetched at once
+    template <typename Key> std::size_t hash_code(Key const &key) const;
+    void prefetch(std::size_t code) const;
+    unsigned char *new_control(int size) const;
+    void delete_control(unsigned char *ctrl, int size) const;
+    template <typename Key>
+    static int locate(Key const &key, std::size_t code, Type const *arr,
+                      unsigned char const *ctrl, int size, int *probes = nullptr);
+    static void count_probes(int *probes, int n);
+    void count_lookup(bool hit, int probes) const;
+    void count_change(bool insertion) const;
+    int locate_free(unsigned char const *ctrl, int size, std::size_t code,
+                    unsigned char a, unsigned char b) const;
+    template <typename Key>
+    int locate_insert(Key const &key, std::size_t code, int &free) const;
+    
+    // resizing helpers
+    void grow();
+    void migrate(int bins) const;
+    void place(Type &obj) const;
+    void release_old() const;
+    void check_erased();
+    
+    // bulk building helpers
+    template <typename Iterator>
+    void build(Iterator first, Iterator last, int threads, std::input_iterator_tag);
+    template <typename Iterator>
+    void build(Iterator first, Iterator last, int threads, std::random_access_iterator_tag);
+    template <typename Iterator>
+    int fill_region(Iterator first, std::size_t const *codes, int const *order, int lo, int hi,
+                    int begin, int end, std::vector<int> &overflow);
+    template <typename Function> static void run_threads(int threads, Function f);
+    
+public:
     
     // Friends
     
-    template <typename T>
-    friend std::ostream &operator<<( std::ostream &, Quadratic_hash_table<T> const & );
+    friend class Quadratic_hash_table_image<Type, Probe, Hash>;
+    
+    template <typename T, typename P, typename H, typename A>
+    friend std::ostream &operator<<( std::ostream &, Quadratic_hash_table<T, P, H, A> const & );
+};
+
+/*
+ * Quadratic_hash_table::const_iterator
+ *
+ * A forward iterator over the entries of a hash table in bin order.
+ * It keeps the occupancy bitmap of the 64 bins around its position,
+ * less the bins already visited.  Entries cannot be modified through
+ * an iterator, since that could change their bins.  Any insertion,
+ * erasure or clear() invalidates all iterators.
+ */
+template <typename Type, typename Probe, typename Hash, typename Alloc>
+class Quadratic_hash_table<Type, Probe, Hash, Alloc>::const_iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Type const *pointer;
+    typedef Type const &reference;
+    
+private:
+    Quadratic_hash_table const *table;
+    int current;                // bin of the current entry, or the capacity at the end
+    int base;                   // first bin of the current word
+    unsigned long long bits;    // occupied bins of the word not yet visited
+    
+public:
+    const_iterator():
+    table( nullptr ), current( 0 ), base( 0 ), bits( 0 ) {
+        // empty constructor
+    }
+    
+    const_iterator(Quadratic_hash_table const *t, int bin):
+    table( t ), current( bin ), base( bin ), bits( 0 ) {
+        if (current < table->array_size) {
+            bits = occupied_bits(table->control + base, std::min(64, table->array_size - base));
+            advance();
+        }
+    }
+    
+    reference operator*() const {
+        return table->array[current];
+    }
+    
+    pointer operator->() const {
+        return table->array + current;
+    }
+    
+    const_iterator &operator++() {
+        bits &= bits - 1;
+        advance();
+        return *this;
+    }
+    
+    const_iterator operator++(int) {
+        const_iterator previous = *this;
+        ++*this;
+        return previous;
+    }
+    
+    bool operator==(const_iterator const &other) const {
+        return current == other.current;
+    }
+    
+    bool operator!=(const_iterator const &other) const {
+        return current != other.current;
+    }
+    
+private:
+    // move to the lowest bin left in bits, loading words as needed
+    void advance() {
+        while (bits == 0) {
+            base += 64;
+            
+            if (base >= table->array_size) {
+                current = table->array_size;
+                return;
+            }
+            
+            bits = occupied_bits(table->control + base, std::min(64, table->array_size - base));
+        }
+        
+        current = base + lowest_bit64(bits);
+    }
 };
 
 /*********************************************************************
@@ -102,21 +411,28 @@ public:
  *********************************************************************/
 
 /*
- * Constructor: Quadratic_hash_table(int n)
+ * Constructor: Quadratic_hash_table(int n, Hash const &h, Alloc const &a)
  *
- * Creates a new hash table instance with capacity of 2^n
+ * Creates a new hash table instance with capacity of 2^n that
+ * hashes its entries with h and takes its storage from a
  */
-template <typename Type>
-Quadratic_hash_table<Type>::Quadratic_hash_table(int n):
-count( 0 ), power( n ), erased( 0 ),
+template <typename Type, typename Probe, typename Hash, typename Alloc>
+Quadratic_hash_table<Type, Probe, Hash, Alloc>::Quadratic_hash_table(int n, Hash const &h, Alloc const &a):
+count( 0 ), power( n ),
 array_size( 1 << power ),
 mask( array_size - 1 ),
-array( new Type[array_size] ),
-occupied( new bin_state_t[array_size] ) {
-    
-    for ( int i = 0; i < array_size; ++i ) {
-        occupied[i] = UNOCCUPIED;
-    }
+erased( 0 ), hasher( h ), allocator( a ),
+array( new_array( array_size ) ),
+control( new_control( array_size ) ),
+max_load( 1.0 ),
+old_size( 0 ),
+migrated( 0 ),
+old_array( nullptr ),
+old_control( nullptr ),
+max_erased( 1.0 ),
+n_compactions( 0 ),
+n_reclaimed( 0 ) {
+    // empty constructor
 }
 
 /*
@@ -124,29 +440,36 @@ occupied( new bin_state_t[array_size] ) {
  *
  * Creates a new hash table instance with capacity of 2^5
  */
-template <typename Type>
-Quadratic_hash_table<Type>::Quadratic_hash_table():
-count( 0 ), power( m ), erased( 0 ),
+template <typename Type, typename Probe, typename Hash, typename Alloc>
+Quadratic_hash_table<Type, Probe, Hash, Alloc>::Quadratic_hash_table():
+count( 0 ), power( m ),
 array_size( 1 << power ),
 mask( array_size - 1 ),
-array( new Type[array_size] ),
-occupied( new bin_state_t[array_size] ) {
-    
-    for ( int i = 0; i < array_size; ++i ) {
-        occupied[i] = UNOCCUPIED;
-    }
+erased( 0 ),
+array( new_array( array_size ) ),
+control( new_control( array_size ) ),
+max_load( 1.0 ),
+old_size( 0 ),
+migrated( 0 ),
+old_array( nullptr ),
+old_control( nullptr ),
+max_erased( 1.0 ),
+n_compactions( 0 ),
+n_reclaimed( 0 ) {
+    // empty constructor
 }
 
 /*
  * Destructor:
  *
  */
-template <typename Type>
-Quadratic_hash_table<Type>::~Quadratic_hash_table() {
+template <typename Type, typename Probe, typename Hash, typename Alloc>
+Quadratic_hash_table<Type, Probe, Hash, Alloc>::~Quadratic_hash_table() {
     
-    //delete arrays
-    delete [] array;
-    delete [] occupied;
+    //destroy the entries and delete arrays
+    delete_array(array, control, array_size);
+    delete_control(control, array_size);
+    release_old();
 }
 
 /*********************************************************************
@@ -162,8 +485,8 @@ Quadratic_hash_table<Type>::~Quadratic_hash_table() {
  *
  * Returns: number of entities in the hash table
  */
-template<typename Type>
-int Quadratic_hash_table<Type>::size() const {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::size() const {
     return count;
 }
 
@@ -172,8 +495,8 @@ int Quadratic_hash_table<Type>::size() const {
  *
  * Returns: the capacity of the current array
  */
-template<typename Type>
-int Quadratic_hash_table<Type>::capacity() const {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::capacity() const {
     return array_size;
 }
 
@@ -185,8 +508,8 @@ int Quadratic_hash_table<Type>::capacity() const {
  *
  * Returns:
  */
-template<typename Type>
-double Quadratic_hash_table<Type>::load_factor() const {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+double Quadratic_hash_table<Type, Probe, Hash, Alloc>::load_factor() const {
     return (double)(erased + count) / (double)array_size;
 }
 
@@ -195,8 +518,8 @@ double Quadratic_hash_table<Type>::load_factor() const {
  *
  * Returns: true if the hash table has no elements in it
  */
-template<typename Type>
-bool Quadratic_hash_table<Type>::empty() const {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::empty() const {
     return count == 0;
 }
 
@@ -207,42 +530,39 @@ bool Quadratic_hash_table<Type>::empty() const {
  *
  * Returns: true if the hash table contains the obj
  */
-template<typename Type>
-bool Quadratic_hash_table<Type>::member(Type const &obj) const {
-    // initial bin
-    int bin = hash(obj);
-    
-    // retrun if matched and occupied
-    if (occupied[bin] == OCCUPIED && array[bin] == obj){
-        return true;
-    }
-    
-    // quadratically probe array for obj
-    for (int i = 0; i < capacity(); i++) {
-        bin = (bin + i) % capacity();
-        if (occupied[bin] == OCCUPIED && array[bin] == obj){
-            return true;
-        }
-    }
-    
-    // obj not found
-    return false;
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::member(Type const &obj) const {
+    return lookup(obj) != nullptr;
 }
 
 /*
  * Accessor: int hash(Type const &obj)
  *
- * Returns: hash value for obj
+ * Returns: hash value for obj, the home bin of its probe sequence
  */
-template<typename Type>
-int Quadratic_hash_table<Type>::hash(Type const &obj) const {
-    int i  = static_cast<int>(obj);
-    
-    if (i >= 0) {
-        return i % array_size;
-    } else {
-        return i % array_size + array_size;
-    }
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::hash(Type const &obj) const {
+    return static_cast<int>(hash_code(obj) & mask);
+}
+
+/*
+ * Accessor: Hash hash_function()
+ *
+ * Returns: a copy of the hash function object
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+Hash Quadratic_hash_table<Type, Probe, Hash, Alloc>::hash_function() const {
+    return hasher;
+}
+
+/*
+ * Accessor: Alloc get_allocator()
+ *
+ * Returns: a copy of the allocator the arrays are taken from
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+Alloc Quadratic_hash_table<Type, Probe, Hash, Alloc>::get_allocator() const {
+    return allocator;
 }
 
 /*
@@ -250,13 +570,29 @@ int Quadratic_hash_table<Type>::hash(Type const &obj) const {
  *
  * Returns: value in bin
  */
-template<typename Type>
-Type Quadratic_hash_table<Type>::bin(int n) const {
-    if (occupied[n] == OCCUPIED) {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+Type Quadratic_hash_table<Type, Probe, Hash, Alloc>::bin(int n) const {
+    if (state(n) == OCCUPIED) {
         return array[n];
     } else {
-        //TODO
-        return array[n];
+        // no entry is constructed in this bin
+        return Type();
+    }
+}
+
+/*
+ * Accessor: bin_state_t state(int n)
+ *
+ * Returns: whether bin n is unoccupied, occupied or erased
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+bin_state_t Quadratic_hash_table<Type, Probe, Hash, Alloc>::state(int n) const {
+    if (control[n] == CONTROL_UNOCCUPIED) {
+        return UNOCCUPIED;
+    } else if (control[n] == CONTROL_ERASED) {
+        return ERASED;
+    } else {
+        return OCCUPIED;
     }
 }
 
@@ -265,11 +601,314 @@ Type Quadratic_hash_table<Type>::bin(int n) const {
  *
  * Returns:
  */
-template<typename Type>
-void Quadratic_hash_table<Type>::print() const {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::print() const {
     //TODO OR NOT TODO
 }
 
+/*
+ * Accessor: double max_load_factor()
+ *
+ * Returns: the load factor above which the table is resized
+ *          (1.0 means the table is never resized)
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+double Quadratic_hash_table<Type, Probe, Hash, Alloc>::max_load_factor() const {
+    return max_load;
+}
+
+/*
+ * Accessor: bool resizing()
+ *
+ * Returns: true while entries are still being migrated out of
+ *          the array that was in use before the last resize
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::resizing() const {
+    return old_array != nullptr;
+}
+
+/*
+ * Accessor: double max_erased_ratio()
+ *
+ * Returns: the fraction of the capacity that erased bins may reach
+ *          before the table is compacted (1.0 means never)
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+double Quadratic_hash_table<Type, Probe, Hash, Alloc>::max_erased_ratio() const {
+    return max_erased;
+}
+
+/*
+ * Accessor: int compactions()
+ *
+ * Returns: the number of compactions performed so far, whether
+ *          triggered automatically or by calling compact()
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::compactions() const {
+    return n_compactions;
+}
+
+/*
+ * Accessor: int reclaimed()
+ *
+ * Returns: the number of erased bins reclaimed by the last compaction
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::reclaimed() const {
+    return n_reclaimed;
+}
+
+/*
+ * Accessor: Quadratic_hash_table_stats stats()
+ *           Scan the table for its probe lengths, clusters and home
+ *           bin collisions; a resize in progress is finished first.
+ *           The miss probe lengths are those of a search that starts
+ *           at each group in turn with a hash code equal to the first
+ *           bin of the group.
+ *
+ * Returns: the statistics of the table and its runtime counters
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+Quadratic_hash_table_stats Quadratic_hash_table<Type, Probe, Hash, Alloc>::stats() const {
+    migrate(old_size);
+    
+#ifdef QUADRATIC_HASH_TABLE_STATS
+    Quadratic_hash_table_stats s = counters;
+    s.counted = true;
+#else
+    Quadratic_hash_table_stats s;
+#endif
+    
+    int groups = std::max(array_size / Probe::width, 1);
+    
+    s.size = count;
+    s.capacity = array_size;
+    s.erased = erased;
+    s.load_factor = load_factor();
+    s.tombstone_ratio = static_cast<double>(erased) / array_size;
+    s.array_bytes = static_cast<unsigned long long>(sizeof(Type)) * array_size;
+    s.control_bytes = std::max(array_size, static_cast<int>(Probe::width));
+    
+    // probes to reach each entry from its home bin
+    std::vector<bool> home_taken(array_size, false);
+    double hit_total = 0.0;
+    
+    for (int bin = 0; bin < array_size; ++bin) {
+        if (control[bin] >= CONTROL_UNOCCUPIED) {
+            continue;
+        }
+        
+        std::size_t code = hash_code(array[bin]);
+        int home = static_cast<int>(code & mask);
+        typename Probe::sequence seq(home / Probe::width, code, groups - 1);
+        int probes = 1;
+        
+        if (home_taken[home]) {
+            s.home_collisions++;
+        }
+        
+        home_taken[home] = true;
+        
+        for (; seq.position() != bin / Probe::width && probes < groups; seq.next()) {
+            probes++;
+        }
+        
+        hit_total += probes;
+        s.max_hit_probes = std::max(s.max_hit_probes, probes);
+    }
+    
+    s.mean_hit_probes = (count == 0) ? 0.0 : hit_total / count;
+    
+    // probes to reach a group with an unoccupied bin from each group
+    double miss_total = 0.0;
+    
+    for (int start = 0; start < groups; ++start) {
+        typename Probe::sequence seq(start, static_cast<std::size_t>(start) * Probe::width, groups - 1);
+        int probes = 1;
+        
+        for (; group(control + seq.position() * Probe::width).match(CONTROL_UNOCCUPIED) == 0
+               && probes < groups; seq.next()) {
+            probes++;
+        }
+        
+        miss_total += probes;
+        s.max_miss_probes = std::max(s.max_miss_probes, probes);
+    }
+    
+    s.mean_miss_probes = miss_total / groups;
+    
+    // runs of occupied and erased bins
+    for (int bin = 0; bin < array_size; ) {
+        int length = 0;
+        
+        while (bin < array_size && control[bin] != CONTROL_UNOCCUPIED) {
+            length++;
+            bin++;
+        }
+        
+        if (length > 0) {
+            int bucket = 31 - __builtin_clz(length);
+            
+            s.clusters[std::min(bucket, Quadratic_hash_table_stats::CLUSTER_BUCKETS - 1)]++;
+            s.max_cluster = std::max(s.max_cluster, length);
+        } else {
+            bin++;
+        }
+    }
+    
+    return s;
+}
+
+/*
+ * Accessor: int member_batch(Type const *objs, int n, unsigned long long *found)
+ *           Check the n entries of objs for membership.  Bit i of the
+ *           bitmap found (n bits, 64 per word) is set if objs[i] is
+ *           in the hash table and cleared otherwise.
+ *
+ *           The keys are taken in blocks: every key of a block is
+ *           hashed and its home bin prefetched before the first of
+ *           them is probed, so that the cache misses of the block
+ *           overlap instead of following one another.
+ *
+ * Returns: the number of entries found
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::member_batch(Type const *objs, int n,
+                                                          unsigned long long *found) const {
+    std::size_t codes[batch];
+    int hits = 0;
+    
+    for (int first = 0; first < n; first += batch) {
+        int last = std::min(first + batch, n);
+        
+        for (int i = first; i < last; ++i) {
+            codes[i - first] = hash_code(objs[i]);
+            prefetch(codes[i - first]);
+        }
+        
+        for (int i = first; i < last; ++i) {
+            unsigned long long bit = 1ULL << (i % 64);
+            
+            if (lookup(objs[i], codes[i - first]) != nullptr) {
+                found[i / 64] |= bit;
+                hits++;
+            } else {
+                found[i / 64] &= ~bit;
+            }
+        }
+    }
+    
+    return hits;
+}
+
+/*
+ * Accessor: bool save(char const *path)
+ *           Write an image of the hash table to the file at path (see
+ *           Table_image.h), recording the seed of the hash function.
+ *           A resize in progress is completed first.  Type must be
+ *           trivially copyable.
+ *
+ * Returns: true if the whole image was written
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::save(char const *path) const {
+    static_assert(std::is_trivially_copyable<Type>::value,
+                  "only tables of trivially copyable types can be saved");
+    
+    const int chunk = 1024;                 // entries written at a time
+    static const unsigned char zeros[64] = { 0 };
+    
+    migrate(old_size);
+    
+    Table_image_header header;
+    std::memset(&header, 0, sizeof(header));
+    
+    header.magic = TABLE_IMAGE_MAGIC;
+    header.version = TABLE_IMAGE_VERSION;
+    header.endian = TABLE_IMAGE_ENDIAN;
+    header.power = power;
+    header.count = count;
+    header.erased = erased;
+    header.probe_width = Probe::width;
+    header.probe_id = Probe::id;
+    header.hash_id = Hash::id;
+    header.type_size = sizeof(Type);
+    header.type_align = alignof(Type);
+    header.seed = hasher.seed();
+    header.control_offset = image_align(sizeof(header));
+    header.control_size = std::max(array_size, static_cast<int>(Probe::width));
+    header.array_offset = image_align(header.control_offset + header.control_size);
+    header.file_size = header.array_offset + sizeof(Type) * static_cast<unsigned long long>(array_size);
+    
+    std::FILE *file = std::fopen(path, "wb");
+    
+    if (file == nullptr) {
+        return false;
+    }
+    
+    // the header is written again once the checksum is known
+    std::size_t header_padding = header.control_offset - sizeof(header);
+    std::size_t control_padding = header.array_offset - header.control_offset - header.control_size;
+    
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && std::fwrite(zeros, 1, header_padding, file) == header_padding;
+    ok = ok && std::fwrite(control, 1, header.control_size, file) == header.control_size;
+    ok = ok && std::fwrite(zeros, 1, control_padding, file) == control_padding;
+    
+    unsigned long long checksum = image_checksum(&header, sizeof(header), TABLE_IMAGE_FNV_BASIS);
+    checksum = image_checksum(control, header.control_size, checksum);
+    std::vector<unsigned char> buffer(chunk * sizeof(Type));
+    
+    for (int first = 0; ok && first < array_size; first += chunk) {
+        int n = std::min(chunk, array_size - first);
+        
+        for (int i = 0; i < n; ++i) {
+            if (control[first + i] < CONTROL_UNOCCUPIED) {
+                std::memcpy(&buffer[i * sizeof(Type)], array + first + i, sizeof(Type));
+            } else {
+                std::memset(&buffer[i * sizeof(Type)], 0, sizeof(Type));
+            }
+        }
+        
+        checksum = image_checksum(&buffer[0], n * sizeof(Type), checksum);
+        ok = std::fwrite(&buffer[0], sizeof(Type), n, file) == static_cast<std::size_t>(n);
+    }
+    
+    header.checksum = checksum;
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    
+    return (std::fclose(file) == 0) && ok;
+}
+
+/*
+ * Accessor: const_iterator begin()
+ *           A resize in progress is completed first, so that every
+ *           entry is in the current array.
+ *
+ * Returns: an iterator to the entry in the lowest occupied bin
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+typename Quadratic_hash_table<Type, Probe, Hash, Alloc>::const_iterator
+Quadratic_hash_table<Type, Probe, Hash, Alloc>::begin() const {
+    migrate(old_size);
+    
+    return const_iterator(this, 0);
+}
+
+/*
+ * Accessor: const_iterator end()
+ *
+ * Returns: the iterator past the last entry
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+typename Quadratic_hash_table<Type, Probe, Hash, Alloc>::const_iterator
+Quadratic_hash_table<Type, Probe, Hash, Alloc>::end() const {
+    return const_iterator(this, array_size);
+}
+
 /*********************************************************************
  * ***************************************************************** *
  * *                                                               * *
@@ -284,126 +923,1161 @@ void Quadratic_hash_table<Type>::print() const {
  *         next empty bins. 
  *         Duplicates are ignored.
  *         
+ *         The capacity is doubled first if the insertion would take
+ *         the load factor above max_load_factor().
+ *
  *         An exception is thrown if the hash table is already full
  */
-template<typename Type>
-void Quadratic_hash_table<Type>::insert(Type const &obj) {
-    // hash value
-    int h = hash(obj);
-    if(size() == capacity()) {
-        throw overflow();
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::insert(Type const &obj) {
+    bool inserted;
+    Type *slot = claim(obj, inserted);
+    
+    if (inserted) {
+        construct(slot, obj);
     }
-    //insertion
-    switch (occupied[h]) {
-        case UNOCCUPIED:
-            //insert and set flag
-            array[h] = obj;
-            occupied[h] = OCCUPIED;
-            count++;
-            return;
-            
-        case OCCUPIED:
-            //quadratically probe for an empty bin
-            for (int i = 0; i < capacity(); i++) {
-                h = (h + i) % capacity();
-                if (occupied[h] == UNOCCUPIED || occupied[h] == ERASED) {
-                    if(array[h] != obj) {
-                        //insertion
-                        array[h] = obj;
-                        if (occupied[h] == ERASED) erased--;
-                        occupied[h] = OCCUPIED;
-                        //update counters
-                        count++;
-                        return;
-                    }
-                }
-                //break if duplicates found
-                if(array[h] == obj && occupied[h] == OCCUPIED) {
-                    return;
-                }
-            }
-            
-        case ERASED:
-            //insert and set flag
-            array[h] = obj;
-            occupied[h] = OCCUPIED;
-            //update counters
-            count++;
-            erased--;
-            return;
+}
+
+/*
+ * Method: void insert(Type &&obj)
+ *         As insert(Type const &), but a new entry is moved from obj
+ *         rather than copied.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::insert(Type &&obj) {
+    bool inserted;
+    Type *slot = claim(obj, inserted);
+    
+    if (inserted) {
+        construct(slot, std::move(obj));
     }
 }
 
+/*
+ * Method: void emplace(Args&&... args)
+ *         Insert the entry constructed from args.  The entry must be
+ *         built before its bin is known, so it is constructed once
+ *         as a temporary and then moved into its bin.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename... Args>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::emplace(Args&&... args) {
+    insert(Type(std::forward<Args>(args)...));
+}
+
 /*
  * Method: bool erase(Type const &obj)
  *
  * Returns: true if obj is deleted from hash table
  */
-template<typename Type>
-bool Quadratic_hash_table<Type>::erase(Type const &obj) {
-    
-    //initial bin
-    int bin = hash(obj);
-    
-    //check initial bin
-    if (array[bin] == obj && occupied[bin] == OCCUPIED){
-        //erase and update counters
-        occupied[bin] = ERASED;
-        erased++;
-        count--;
-        return true;
-    }
-    
-    //quadratically probe array for obj
-    for (int i = 0; i < capacity(); i++) {
-        bin = (bin + i) % capacity();
-        if (array[bin] == obj && occupied[bin] == OCCUPIED){
-            //erase and update counters
-            occupied[bin] = ERASED;
-            erased++;
-            count--;
-            return true;
-        }
-    }
-    
-    // obj not found
-    return false;
-    
-    
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::erase(Type const &obj) {
+    return remove(obj);
 }
 
 /*
  * Method: clear hash table and reinitialize
- *
+ *         The entries are destroyed but the array is kept.
  */
-template<typename Type>
-void Quadratic_hash_table<Type>::clear() {
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::clear() {
+    
+    //destroy the entries and erase all occupied bins
+    destroy(array, control, array_size);
     
-    //erase all occupied bins
     for (int i = 0; i < capacity(); i++) {
-        occupied[i] = UNOCCUPIED;
+        control[i] = CONTROL_UNOCCUPIED;
     }
     
     erased = 0;
     count = 0;
     
-    delete[] array;
-    array = new Type[array_size];
+    release_old();
 }
 
-template <typename T>
-std::ostream &operator<<( std::ostream &out, Quadratic_hash_table<T> const &hash ) {
-    for ( int i = 0; i < hash.capacity(); ++i ) {
-        if ( hash.occupied[i] == UNOCCUPIED ) {
-            out << "- ";
-        } else if ( hash.occupied[i] == ERASED ) {
-            out << "x ";
-        } else {
-            out << hash.array[i] << ' ';
+/*
+ * Method: int insert_batch(Type const *objs, int n, unsigned long long *inserted)
+ *         Insert the n entries of objs, hashing and prefetching them
+ *         a block at a time as member_batch() does.  Bit i of the
+ *         bitmap inserted is set if objs[i] was inserted and cleared
+ *         if it was already present.
+ *
+ *         An exception is thrown if the hash table becomes full; the
+ *         entries before the one that did not fit remain inserted.
+ *
+ * Returns: the number of entries inserted
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::insert_batch(Type const *objs, int n,
+                                                          unsigned long long *inserted) {
+    std::size_t codes[batch];
+    int added = 0;
+    
+    for (int first = 0; first < n; first += batch) {
+        int last = std::min(first + batch, n);
+        
+        for (int i = first; i < last; ++i) {
+            codes[i - first] = hash_code(objs[i]);
+            prefetch(codes[i - first]);
+        }
+        
+        for (int i = first; i < last; ++i) {
+            unsigned long long bit = 1ULL << (i % 64);
+            bool added_obj;
+            Type *slot = claim(objs[i], codes[i - first], added_obj);
+            
+            if (added_obj) {
+                construct(slot, objs[i]);
+                inserted[i / 64] |= bit;
+                added++;
+            } else {
+                inserted[i / 64] &= ~bit;
+            }
         }
     }
     
-    return out;
+    return added;
 }
 
-#endif
\ No newline at end of file
+/*
+ * Method: int erase_batch(Type const *objs, int n, unsigned long long *erased_objs)
+ *         Erase the n entries of objs, hashing and prefetching them
+ *         a block at a time as member_batch() does.  Bit i of the
+ *         bitmap erased_objs is set if objs[i] was erased and cleared
+ *         if it was not present.
+ *
+ * Returns: the number of entries erased
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::erase_batch(Type const *objs, int n,
+                                                         unsigned long long *erased_objs) {
+    std::size_t codes[batch];
+    int removed = 0;
+    
+    for (int first = 0; first < n; first += batch) {
+        int last = std::min(first + batch, n);
+        
+        for (int i = first; i < last; ++i) {
+            codes[i - first] = hash_code(objs[i]);
+            prefetch(codes[i - first]);
+        }
+        
+        for (int i = first; i < last; ++i) {
+            unsigned long long bit = 1ULL << (i % 64);
+            
+            if (remove(objs[i], codes[i - first])) {
+                erased_objs[i / 64] |= bit;
+                removed++;
+            } else {
+                erased_objs[i / 64] &= ~bit;
+            }
+        }
+    }
+    
+    return removed;
+}
+
+/*
+ * Method: void build(Iterator first, Iterator last, int threads)
+ *         Replace the contents of the hash table with the entries in
+ *         [first, last), ignoring duplicates as insert() does.  The
+ *         capacity is chosen so that the load factor is at most half
+ *         of max_load_factor(), leaving room to insert as many again.
+ *
+ *         With enough entries, the work is split over the given number
+ *         of threads (by default one per hardware thread):
+ *          - the entries are hashed and sorted, by a counting sort, on
+ *            the leading bits of their home bin; these bits select one
+ *            of a power-of-two number of equal regions of the array
+ *          - each thread fills whole regions, probing only within the
+ *            region, so no two threads touch the same bins and no lock
+ *            is taken
+ *          - an entry whose probe sequence leaves its region before
+ *            reaching an unoccupied bin is inserted afterwards by the
+ *            calling thread, as insert() would
+ *
+ *         An exception is thrown if the entries do not fit in 2^30 bins
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Iterator>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::build(Iterator first, Iterator last, int threads) {
+    build(first, last, threads, typename std::iterator_traits<Iterator>::iterator_category());
+}
+
+/*
+ * Method: void max_load_factor(double load)
+ *         Set the load factor above which the capacity is doubled.
+ *         A value of 1.0 (the default) disables resizing.
+ *
+ *         An exception is thrown if load is not in (0, 1]
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::max_load_factor(double load) {
+    if (!(load > 0.0 && load <= 1.0)) {
+        throw illegal_argument();
+    }
+    
+    max_load = load;
+}
+
+/*
+ * Method: void max_erased_ratio(double ratio)
+ *         Set the fraction of the capacity that erased bins may
+ *         occupy before erase() compacts the table.  A value of
+ *         1.0 (the default) disables automatic compaction.
+ *
+ *         An exception is thrown if ratio is not in (0, 1]
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::max_erased_ratio(double ratio) {
+    if (!(ratio > 0.0 && ratio <= 1.0)) {
+        throw illegal_argument();
+    }
+    
+    max_erased = ratio;
+}
+
+/*
+ * Method: int compact()
+ *         Rehash the entries in place so that every erased bin
+ *         becomes unoccupied again.  No array is allocated: the
+ *         entries are marked REHASHING and then each is moved (or
+ *         swapped with another pending entry) into the first free
+ *         position of its probe sequence.  An entry already in the
+ *         group of bins its probe would reach first stays put.
+ *
+ * Returns: the number of erased bins reclaimed
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::compact() {
+    // the old array is drained first so that all entries are local
+    migrate(old_size);
+    
+    for (int i = 0; i < capacity(); i++) {
+        if (control[i] == CONTROL_ERASED) {
+            control[i] = CONTROL_UNOCCUPIED;
+        } else if (control[i] != CONTROL_UNOCCUPIED) {
+            control[i] = CONTROL_REHASHING;
+        }
+    }
+    
+    for (int i = 0; i < capacity(); i++) {
+        while (control[i] == CONTROL_REHASHING) {
+            std::size_t code = hash_code(array[i]);
+            int bin = locate_free(control, array_size, code,
+                                  CONTROL_UNOCCUPIED, CONTROL_REHASHING);
+            
+            if (bin / Probe::width == i / Probe::width) {
+                // already in place
+                control[i] = control_tag(code);
+            } else if (control[bin] == CONTROL_UNOCCUPIED) {
+                new (array + bin) Type(std::move(array[i]));
+                array[i].~Type();
+                control[bin] = control_tag(code);
+                control[i] = CONTROL_UNOCCUPIED;
+            } else {
+                // the displaced entry is rehashed on the next pass
+                std::swap(array[bin], array[i]);
+                control[bin] = control_tag(code);
+            }
+        }
+    }
+    
+    n_reclaimed = erased;
+    n_compactions++;
+    erased = 0;
+    
+    return n_reclaimed;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Lookups by key                                              * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: Type *lookup(Key const &key)
+ *           Search the old array (while resizing) and the current
+ *           array for the entry equal to key.  Key may be Type or
+ *           any type that Hash accepts and Type compares equal to.
+ *
+ * Returns: a pointer to the entry, or nullptr if there is none
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+Type *Quadratic_hash_table<Type, Probe, Hash, Alloc>::lookup(Key const &key) const {
+    return lookup(key, hash_code(key));
+}
+
+/*
+ * Accessor: Type *lookup(Key const &key, std::size_t code)
+ *           As lookup(key), where code is the hash code of key.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+Type *Quadratic_hash_table<Type, Probe, Hash, Alloc>::lookup(Key const &key, std::size_t code) const {
+    // move a few entries over if a resize is in progress
+    migrate(step);
+    
+    int probes = 0;
+    
+    if (old_array != nullptr) {
+        int old_bin = locate(key, code, old_array, old_control, old_size, &probes);
+        
+        if (old_bin != -1) {
+            count_lookup(true, probes);
+            return old_array + old_bin;
+        }
+    }
+    
+    int bin = locate(key, code, array, control, array_size, &probes);
+    
+    count_lookup(bin != -1, probes);
+    
+    return (bin == -1) ? nullptr : array + bin;
+}
+
+/*
+ * Method: Type *claim(Key const &key, bool &inserted)
+ *         Find the entry equal to key or, if there is none, claim a
+ *         bin for it with a single probe of the current array.  A
+ *         claimed bin is counted and tagged as occupied; the caller
+ *         must store the new entry in it.
+ *
+ *         The capacity is doubled first if the insertion would take
+ *         the load factor above max_load_factor().
+ *
+ *         An exception is thrown if the hash table is already full
+ *
+ * Returns: a pointer to the existing entry (inserted is false) or to
+ *          the claimed bin (inserted is true)
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+Type *Quadratic_hash_table<Type, Probe, Hash, Alloc>::claim(Key const &key, bool &inserted) {
+    return claim(key, hash_code(key), inserted);
+}
+
+/*
+ * Method: Type *claim(Key const &key, std::size_t code, bool &inserted)
+ *         As claim(key, inserted), where code is the hash code of key.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+Type *Quadratic_hash_table<Type, Probe, Hash, Alloc>::claim(Key const &key, std::size_t code,
+                                                     bool &inserted) {
+    // move a few entries over if a resize is in progress
+    migrate(step);
+    
+    // resize before the load factor crosses the threshold, unless
+    // reclaiming the erased bins alone brings it well below
+    if (max_load < 1.0 && erased + count + 1 > max_load * capacity()) {
+        if (2 * (count + 1) <= max_load * capacity()) {
+            compact();
+        } else {
+            grow();
+        }
+    }
+    
+    inserted = false;
+    
+    // duplicates still waiting in the old array are found there
+    if (old_array != nullptr) {
+        int old_bin = locate(key, code, old_array, old_control, old_size);
+        
+        if (old_bin != -1) {
+            return old_array + old_bin;
+        }
+    }
+    
+    if(size() == capacity()) {
+        throw overflow();
+    }
+    
+    //probe for key, remembering the first free bin
+    int bin;
+    int found = locate_insert(key, code, bin);
+    
+    if (found != -1) {
+        return array + found;
+    }
+    
+    if (control[bin] == CONTROL_ERASED) {
+        erased--;
+    }
+    
+    control[bin] = control_tag(code);
+    count++;
+    inserted = true;
+    count_change(true);
+    
+    return array + bin;
+}
+
+/*
+ * Method: bool remove(Key const &key)
+ *
+ * Returns: true if the entry equal to key is deleted from hash table
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::remove(Key const &key) {
+    return remove(key, hash_code(key));
+}
+
+/*
+ * Method: bool remove(Key const &key, std::size_t code)
+ *         As remove(key), where code is the hash code of key.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+bool Quadratic_hash_table<Type, Probe, Hash, Alloc>::remove(Key const &key, std::size_t code) {
+    // move a few entries over if a resize is in progress
+    migrate(step);
+    
+    // the entry may not have been migrated yet
+    if (old_array != nullptr) {
+        int old_bin = locate(key, code, old_array, old_control, old_size);
+        
+        if (old_bin != -1) {
+            old_array[old_bin].~Type();
+            old_control[old_bin] = CONTROL_ERASED;
+            count--;
+            count_change(false);
+            return true;
+        }
+    }
+    
+    int bin = locate(key, code, array, control, array_size);
+    
+    // key not found
+    if (bin == -1) {
+        return false;
+    }
+    
+    //destroy the entry and update counters
+    array[bin].~Type();
+    control[bin] = CONTROL_ERASED;
+    erased++;
+    count--;
+    count_change(false);
+    check_erased();
+    return true;
+}
+
+/*
+ * Method: void construct(Type *slot, Args&&... args)
+ *         Construct the entry for a bin returned by claim() from args.
+ *         If the constructor throws, the bin is released again (as an
+ *         erased bin) before the exception propagates.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename... Args>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::construct(Type *slot, Args&&... args) {
+    try {
+        new (slot) Type(std::forward<Args>(args)...);
+    } catch (...) {
+        control[slot - array] = CONTROL_ERASED;
+        erased++;
+        count--;
+        throw;
+    }
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Storage                                                     * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: Type *new_array(int size)
+ *         Allocate uninitialized storage for size entries from the
+ *         allocator.
+ *
+ * Returns: the storage; no entry is constructed
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+Type *Quadratic_hash_table<Type, Probe, Hash, Alloc>::new_array(int size) const {
+    return entry_traits::allocate(allocator, size);
+}
+
+/*
+ * Method: void delete_array(Type *arr, unsigned char const *ctrl, int size)
+ *         Destroy the entries of an array and free its storage.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::delete_array(Type *arr, unsigned char const *ctrl,
+                                                                  int size) const {
+    if (arr != nullptr) {
+        destroy(arr, ctrl, size);
+        entry_traits::deallocate(allocator, arr, size);
+    }
+}
+
+/*
+ * Method: void destroy(Type *arr, unsigned char const *ctrl, int size)
+ *         Destroy the entry in every occupied bin of an array.  There
+ *         is nothing to do for trivially destructible types.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::destroy(Type *arr, unsigned char const *ctrl,
+                                                      int size) {
+    if (std::is_trivially_destructible<Type>::value) {
+        return;
+    }
+    
+    for (int i = 0; i < size; ++i) {
+        if (ctrl[i] < CONTROL_UNOCCUPIED || ctrl[i] == CONTROL_REHASHING) {
+            arr[i].~Type();
+        }
+    }
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Probing                                                     * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: std::size_t hash_code(Key const &key)
+ *
+ * Returns: the full hash code of key; hash() keeps its low bits
+ *          and control_tag() derives the tag from it
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+std::size_t Quadratic_hash_table<Type, Probe, Hash, Alloc>::hash_code(Key const &key) const {
+    return hasher(key);
+}
+
+/*
+ * Method: void prefetch(std::size_t code)
+ *         Start loading the control bytes of the first group probed
+ *         for the hash code into the cache.  When a group is a single
+ *         bin its entry is loaded too; in a wider group the matching
+ *         entry is not known yet and loading the home bin would only
+ *         occupy the memory system.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::prefetch(std::size_t code) const {
+    int home = static_cast<int>(code & mask);
+    
+    prefetch_address(control + home / Probe::width * Probe::width);
+    
+    if (Probe::width == 1) {
+        prefetch_address(array + home);
+    }
+}
+
+/*
+ * Method: unsigned char *new_control(int size)
+ *         Allocate the control bytes for an array of the given size,
+ *         padded to at least one full group.
+ *
+ * Returns: the control bytes, all bins unoccupied
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+unsigned char *Quadratic_hash_table<Type, Probe, Hash, Alloc>::new_control(int size) const {
+    control_allocator a(allocator);
+    int padded = std::max(size, static_cast<int>(Probe::width));
+    unsigned char *ctrl = control_traits::allocate(a, padded);
+    
+    for (int i = 0; i < padded; ++i) {
+        ctrl[i] = (i < size) ? CONTROL_UNOCCUPIED : CONTROL_SENTINEL;
+    }
+    
+    return ctrl;
+}
+
+/*
+ * Method: void delete_control(unsigned char *ctrl, int size)
+ *         Free the control bytes of an array of the given size.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::delete_control(unsigned char *ctrl, int size) const {
+    if (ctrl != nullptr) {
+        control_allocator a(allocator);
+        
+        control_traits::deallocate(a, ctrl, std::max(size, static_cast<int>(Probe::width)));
+    }
+}
+
+/*
+ * Accessor: int locate(Key const &key, std::size_t code, ...)
+ *           Probe the given array for key, whose hash code is code,
+ *           stopping at the first group that has an unoccupied bin.
+ *           The number of groups probed is stored in probes when
+ *           the runtime counters are compiled in.
+ *
+ * Returns: the bin holding key, or -1
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::locate(Key const &key, std::size_t code,
+                                                    Type const *arr, unsigned char const *ctrl,
+                                                    int size, int *probes) {
+    unsigned char tag = control_tag(code);
+    int groups = std::max(size / Probe::width, 1);
+    typename Probe::sequence seq((code & (size - 1)) / Probe::width, code, groups - 1);
+    
+    count_probes(probes, groups);
+    
+    for (int i = 0; i < groups; ++i, seq.next()) {
+        int base = seq.position() * Probe::width;
+        group g(ctrl + base);
+        
+        for (unsigned bits = g.match(tag); bits != 0; bits &= bits - 1) {
+            int bin = base + lowest_bit(bits);
+            
+            if (arr[bin] == key) {
+                count_probes(probes, i + 1);
+                return bin;
+            }
+        }
+        
+        if (g.match(CONTROL_UNOCCUPIED) != 0) {
+            count_probes(probes, i + 1);
+            break;
+        }
+    }
+    
+    // key not found
+    return -1;
+}
+
+/*
+ * Method: void count_probes(int *probes, int n)
+ *         Store n in probes, if it is given and the runtime counters
+ *         are compiled in; otherwise do nothing.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::count_probes(int *probes, int n) {
+#ifdef QUADRATIC_HASH_TABLE_STATS
+    if (probes != nullptr) {
+        *probes = n;
+    }
+#else
+    (void) probes;
+    (void) n;
+#endif
+}
+
+/*
+ * Method: void count_lookup(bool hit, int probes)
+ *         Count a search that made the given number of probes.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::count_lookup(bool hit, int probes) const {
+#ifdef QUADRATIC_HASH_TABLE_STATS
+    counters.lookups++;
+    
+    if (hit) {
+        counters.hits++;
+        counters.hit_probes += probes;
+    } else {
+        counters.miss_probes += probes;
+    }
+#else
+    (void) hit;
+    (void) probes;
+#endif
+}
+
+/*
+ * Method: void count_change(bool insertion)
+ *         Count an insertion or an erasure.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::count_change(bool insertion) const {
+#ifdef QUADRATIC_HASH_TABLE_STATS
+    if (insertion) {
+        counters.insertions++;
+    } else {
+        counters.erasures++;
+    }
+#else
+    (void) insertion;
+#endif
+}
+
+/*
+ * Accessor: int locate_free(unsigned char const *ctrl, ...)
+ *
+ * Returns: the first bin in the probe sequence of the hash code
+ *          whose control byte is a or b, or -1 if there is none
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::locate_free(unsigned char const *ctrl, int size,
+                                                   std::size_t code, unsigned char a,
+                                                   unsigned char b) const {
+    int groups = std::max(size / Probe::width, 1);
+    typename Probe::sequence seq((code & (size - 1)) / Probe::width, code, groups - 1);
+    
+    for (int i = 0; i < groups; ++i, seq.next()) {
+        int base = seq.position() * Probe::width;
+        group g(ctrl + base);
+        unsigned bits = g.match(a) | g.match(b);
+        
+        if (bits != 0) {
+            return base + lowest_bit(bits);
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ * Accessor: int locate_insert(Key const &key, std::size_t code, int &free)
+ *           Probe the current array for key in a single pass,
+ *           recording in free the first unoccupied or erased bin.
+ *           No entry lies beyond an unoccupied bin in its probe
+ *           sequence, so the search stops at the first such group.
+ *
+ * Returns: the bin holding key, or -1
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Key>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::locate_insert(Key const &key, std::size_t code,
+                                                           int &free) const {
+    unsigned char tag = control_tag(code);
+    int groups = std::max(array_size / Probe::width, 1);
+    typename Probe::sequence seq(static_cast<int>(code & mask) / Probe::width, code, groups - 1);
+    
+    free = -1;
+    
+    for (int i = 0; i < groups; ++i, seq.next()) {
+        int base = seq.position() * Probe::width;
+        group g(control + base);
+        
+        for (unsigned bits = g.match(tag); bits != 0; bits &= bits - 1) {
+            int bin = base + lowest_bit(bits);
+            
+            if (array[bin] == key) {
+                return bin;
+            }
+        }
+        
+        unsigned empty = g.match(CONTROL_UNOCCUPIED);
+        
+        if (free == -1) {
+            unsigned bits = empty | g.match(CONTROL_ERASED);
+            
+            if (bits != 0) {
+                free = base + lowest_bit(bits);
+            }
+        }
+        
+        if (empty != 0) {
+            break;
+        }
+    }
+    
+    return -1;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Resizing                                                    * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: void grow()
+ *         Double the capacity.  The current arrays become the old
+ *         arrays and are drained incrementally by migrate().
+ *
+ *         The capacity is left unchanged once 2^30 bins are reached.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::grow() {
+    if (power >= 30) {
+        return;
+    }
+    
+    // a migration still in flight is completed first
+    migrate(old_size);
+    
+    old_array = array;
+    old_control = control;
+    old_size = array_size;
+    migrated = 0;
+    
+    power++;
+    array_size = 1 << power;
+    mask = array_size - 1;
+    erased = 0;
+    array = new_array(array_size);
+    control = new_control(array_size);
+}
+
+/*
+ * Method: void migrate(int bins)
+ *         Move the entries of the next 'bins' bins of the old array
+ *         into the current array, and free the old array once it
+ *         has been drained.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::migrate(int bins) const {
+    if (old_array == nullptr) {
+        return;
+    }
+    
+    for (; bins > 0 && migrated < old_size; --bins, ++migrated) {
+        if (old_control[migrated] < CONTROL_UNOCCUPIED) {
+            place(old_array[migrated]);
+            old_control[migrated] = CONTROL_ERASED;
+        }
+    }
+    
+    if (migrated == old_size) {
+        release_old();
+    }
+}
+
+/*
+ * Method: void place(Type &obj)
+ *         Move obj into the first unoccupied bin of its probe sequence
+ *         in the current array and destroy the moved-from entry.  obj
+ *         is known not to be in the array, and erased bins are skipped
+ *         so that erased is unaffected.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::place(Type &obj) const {
+    std::size_t code = hash_code(obj);
+    int bin = locate_free(control, array_size, code, CONTROL_UNOCCUPIED, CONTROL_UNOCCUPIED);
+    
+    new (array + bin) Type(std::move(obj));
+    obj.~Type();
+    control[bin] = control_tag(code);
+}
+
+/*
+ * Method: void release_old()
+ *         Free the old arrays, destroying any entries not yet
+ *         migrated, and end the migration.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::release_old() const {
+    delete_array(old_array, old_control, old_size);
+    delete_control(old_control, old_size);
+    
+    old_array = nullptr;
+    old_control = nullptr;
+    old_size = 0;
+    migrated = 0;
+}
+
+/*
+ * Method: void check_erased()
+ *         Compact the table if the erased bins exceed the threshold.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::check_erased() {
+    if (erased > max_erased * capacity()) {
+        compact();
+    }
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Bulk building                                               * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: void build(Iterator first, Iterator last, int threads, std::input_iterator_tag)
+ *         Entries that cannot be indexed are copied into a vector first.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Iterator>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::build(Iterator first, Iterator last, int threads,
+                                                    std::input_iterator_tag) {
+    std::vector<Type> entries(first, last);
+    
+    build(entries.begin(), entries.end(), threads, std::random_access_iterator_tag());
+}
+
+/*
+ * Method: void build(Iterator first, Iterator last, int threads, std::random_access_iterator_tag)
+ *         See build(first, last, threads).
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Iterator>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::build(Iterator first, Iterator last, int threads,
+                                                    std::random_access_iterator_tag) {
+    const int min_region = 4096;        // smallest region worth a thread
+    const int min_parallel = 1 << 16;   // fewest entries worth threads
+    
+    clear();
+    
+    int n = static_cast<int>(last - first);
+    int p = m;
+    
+    while (p < 30 && n > max_load / 2 * (1 << p)) {
+        p++;
+    }
+    
+    if (p != power) {
+        delete_array(array, control, array_size);
+        delete_control(control, array_size);
+        
+        power = p;
+        array_size = 1 << power;
+        mask = array_size - 1;
+        array = new_array(array_size);
+        control = new_control(array_size);
+    }
+    
+    if (threads <= 0) {
+        threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+    
+    int region_bits = 0;
+    
+    while ((1 << region_bits) < threads && (array_size >> (region_bits + 1)) >= min_region) {
+        region_bits++;
+    }
+    
+    // threads would only get in the way
+    if (region_bits == 0 || n < min_parallel || !std::is_nothrow_copy_constructible<Type>::value) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+        
+        return;
+    }
+    
+    int regions = 1 << region_bits;
+    int shift = power - region_bits;
+    int chunk = (n + threads - 1) / threads;
+    
+    std::vector<std::size_t> codes(n);
+    std::vector<int> order(n);
+    std::vector<int> offsets(threads * regions, 0);
+    std::vector<int> starts(regions + 1, 0);
+    std::vector<std::vector<int> > overflow(regions);
+    std::vector<int> placed(regions, 0);
+    
+    // hash each chunk and count its entries per region
+    run_threads(threads, [&](int t) {
+        int end = std::min(n, (t + 1) * chunk);
+        
+        for (int i = t * chunk; i < end; ++i) {
+            codes[i] = hash_code(first[i]);
+            offsets[t * regions + static_cast<int>((codes[i] & mask) >> shift)]++;
+        }
+    });
+    
+    // each chunk writes its entries of a region after those of the
+    // earlier chunks, so the order within a region is the input order
+    for (int r = 0, total = 0; r < regions; ++r) {
+        starts[r] = total;
+        
+        for (int t = 0; t < threads; ++t) {
+            int count_t = offsets[t * regions + r];
+            
+            offsets[t * regions + r] = total;
+            total += count_t;
+        }
+    }
+    
+    starts[regions] = n;
+    
+    run_threads(threads, [&](int t) {
+        int end = std::min(n, (t + 1) * chunk);
+        
+        for (int i = t * chunk; i < end; ++i) {
+            order[offsets[t * regions + static_cast<int>((codes[i] & mask) >> shift)]++] = i;
+        }
+    });
+    
+    run_threads(threads, [&](int t) {
+        for (int r = t; r < regions; r += threads) {
+            placed[r] = fill_region(first, codes.data(), order.data(), starts[r], starts[r + 1],
+                                    r << shift, (r + 1) << shift, overflow[r]);
+        }
+    });
+    
+    for (int r = 0; r < regions; ++r) {
+        count += placed[r];
+    }
+    
+    for (int r = 0; r < regions; ++r) {
+        for (std::size_t k = 0; k < overflow[r].size(); ++k) {
+            int i = overflow[r][k];
+            bool inserted;
+            Type *slot = claim(first[i], codes[i], inserted);
+            
+            if (inserted) {
+                construct(slot, first[i]);
+            }
+        }
+    }
+}
+
+/*
+ * Method: int fill_region(Iterator first, ...)
+ *         Insert the entries first[order[lo]], ..., first[order[hi - 1]]
+ *         into the bins [begin, end), all of which are only touched by
+ *         the calling thread.  An entry whose probe sequence leaves
+ *         the region before an unoccupied bin is appended to overflow;
+ *         a duplicate is found in the region before that happens, as
+ *         it follows the same sequence.
+ *
+ * Returns: the number of entries placed
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Iterator>
+int Quadratic_hash_table<Type, Probe, Hash, Alloc>::fill_region(Iterator first, std::size_t const *codes,
+                                                         int const *order, int lo, int hi,
+                                                         int begin, int end,
+                                                         std::vector<int> &overflow) {
+    int groups = std::max(array_size / Probe::width, 1);
+    int placed = 0;
+    
+    for (int k = lo; k < hi; ++k) {
+        int i = order[k];
+        std::size_t code = codes[i];
+        unsigned char tag = control_tag(code);
+        typename Probe::sequence seq(static_cast<int>(code & mask) / Probe::width, code, groups - 1);
+        int bin = -1;
+        bool duplicate = false;
+        
+        for (int j = 0; j < groups && !duplicate; ++j, seq.next()) {
+            int base = seq.position() * Probe::width;
+            
+            if (base < begin || base >= end) {
+                break;
+            }
+            
+            group g(control + base);
+            
+            for (unsigned bits = g.match(tag); bits != 0; bits &= bits - 1) {
+                if (array[base + lowest_bit(bits)] == first[i]) {
+                    duplicate = true;
+                    break;
+                }
+            }
+            
+            unsigned empty = g.match(CONTROL_UNOCCUPIED);
+            
+            if (!duplicate && empty != 0) {
+                bin = base + lowest_bit(empty);
+                break;
+            }
+        }
+        
+        if (duplicate) {
+            continue;
+        } else if (bin == -1) {
+            overflow.push_back(i);
+        } else {
+            new (array + bin) Type(first[i]);
+            control[bin] = tag;
+            placed++;
+        }
+    }
+    
+    return placed;
+}
+
+/*
+ * Method: void run_threads(int threads, Function f)
+ *         Call f(0), ..., f(threads - 1) concurrently, f(0) on the
+ *         calling thread, and wait for all of them.
+ */
+template<typename Type, typename Probe, typename Hash, typename Alloc>
+template<typename Function>
+void Quadratic_hash_table<Type, Probe, Hash, Alloc>::run_threads(int threads, Function f) {
+    std::vector<std::thread> workers;
+    
+    for (int t = 1; t < threads; ++t) {
+        workers.push_back(std::thread(f, t));
+    }
+    
+    f(0);
+    
+    for (std::size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+}
+
+template <typename T, typename P, typename H, typename A>
+std::ostream &operator<<( std::ostream &out, Quadratic_hash_table<T, P, H, A> const &hash ) {
+    for ( int i = 0; i < hash.capacity(); ++i ) {
+        if ( hash.state( i ) == UNOCCUPIED ) {
+            out << "- ";
+        } else if ( hash.state( i ) == ERASED ) {
+            out << "x ";
+        } else {
+            out << hash.array[i] << ' ';
+        }
+    }
+    
+    return out;
+}
+
+/*
+ * Prints the statistics one "name value" pair per line, for scraping;
+ * the runtime counters are printed only if they were compiled in.
+ */
+inline std::ostream &operator<<( std::ostream &out, Quadratic_hash_table_stats const &s ) {
+    out << "size " << s.size << '\n'
+        << "capacity " << s.capacity << '\n'
+        << "erased " << s.erased << '\n'
+        << "load_factor " << s.load_factor << '\n'
+        << "tombstone_ratio " << s.tombstone_ratio << '\n'
+        << "array_bytes " << s.array_bytes << '\n'
+        << "control_bytes " << s.control_bytes << '\n'
+        << "home_collisions " << s.home_collisions << '\n'
+        << "mean_hit_probes " << s.mean_hit_probes << '\n'
+        << "max_hit_probes " << s.max_hit_probes << '\n'
+        << "mean_miss_probes " << s.mean_miss_probes << '\n'
+        << "max_miss_probes " << s.max_miss_probes << '\n'
+        << "max_cluster " << s.max_cluster << '\n';
+    
+    for ( int i = 0; i < Quadratic_hash_table_stats::CLUSTER_BUCKETS; ++i ) {
+        if ( s.clusters[i] != 0 ) {
+            out << "clusters_" << (1 << i) << ' ' << s.clusters[i] << '\n';
+        }
+    }
+    
+    if ( s.counted ) {
+        out << "lookups " << s.lookups << '\n'
+            << "hits " << s.hits << '\n'
+            << "hit_probes " << s.hit_probes << '\n'
+            << "miss_probes " << s.miss_probes << '\n'
+            << "insertions " << s.insertions << '\n'
+            << "erasures " << s.erasures << '\n';
+    }
+    
+    return out;
+}
+
+/*
+ * Arena_hash_table
+ *
+ * A Quadratic_hash_table whose arrays are carved from an Arena (see
+ * Allocators.h), for many small, short-lived tables that are all
+ * released together:
+ *
+ *     Arena arena;
+ *     Arena_hash_table<int> table( 5, Default_hash<int>(), arena );
+ */
+template <typename Type, typename Probe = Quadratic_probe, typename Hash = Default_hash<Type> >
+using Arena_hash_table = Quadratic_hash_table<Type, Probe, Hash, Arena_allocator<Type> >;
+
+#endif
@@ -0,0 +1,478 @@
+/****************************************************
+ * Executable:   Quadratic_hash_table_benchmark
+ * Author:  Keshav Kanatala
+ *
+ * Time the basic operations of Quadratic_hash_table.
+ *
+ *   Quadratic_hash_table_benchmark [--type int|double|all]
+ *                                  [--powers MIN:MAX[:STEP]]
+ *                                  [--loads L1,L2,...]
+ *                                  [--csv FILE]
+ *
+ * For each type, each power p (by default 10, 12, ..., 26) and each
+ * load factor (by default 0.25, 0.5, 0.75, 0.9 and 0.95), a table of
+ * 2^p bins is filled to that load and five operations are timed:
+ *
+ *   insert   inserting the keys into an empty table
+ *   hit      looking up keys that are present
+ *   miss     looking up keys that are absent
+ *   erase    erasing every key
+ *   churn    erasing a present key and inserting a new one, at a
+ *            steady load; erased bins are compacted once they exceed
+ *            half of the free bins
+ *
+ * The table does not resize, so every operation runs at the given
+ * load.  Keys are distinct and scattered (i times an odd constant), and
+ * small tables repeat each operation until about 2^20 operations have
+ * been timed.
+ *
+ * Each operation is timed with std::chrono::steady_clock in runs of
+ * 256 calls: ns/op is the total time over the number of calls, and
+ * the percentiles are those of the runs, so a p99 is the cost per call
+ * of the slowest 1% of runs rather than of single calls.  bytes/elem
+ * is the peak storage the table took from its allocator over the
+ * number of keys.
+ *
+ * The results are printed as a table; --csv also writes them to FILE
+ * ("-" writes only CSV to the standard output).  The program exits
+ * with 1 if any lookup returned a wrong answer.
+ ****************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Quadratic_hash_table.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+int const run = 256;                    // calls per timed run
+long const min_ops = 1L << 20;          // calls timed per operation
+
+/*
+ * Storage taken by the tables, counted by Counting_allocator.
+ */
+struct Storage {
+	static std::size_t current;
+	static std::size_t peak;
+
+	static void reset() {
+		current = 0;
+		peak = 0;
+	}
+};
+
+std::size_t Storage::current = 0;
+std::size_t Storage::peak = 0;
+
+template <typename Type>
+class Counting_allocator {
+	public:
+		typedef Type value_type;
+
+		Counting_allocator() {
+			// empty constructor
+		}
+
+		template <typename Other>
+		Counting_allocator( Counting_allocator<Other> const & ) {
+			// empty constructor
+		}
+
+		Type *allocate( std::size_t n ) {
+			Storage::current += n * sizeof( Type );
+			Storage::peak = std::max( Storage::peak, Storage::current );
+
+			return std::allocator<Type>().allocate( n );
+		}
+
+		void deallocate( Type *ptr, std::size_t n ) {
+			Storage::current -= n * sizeof( Type );
+			std::allocator<Type>().deallocate( ptr, n );
+		}
+};
+
+template <typename Type, typename Other>
+bool operator==( Counting_allocator<Type> const &, Counting_allocator<Other> const & ) {
+	return true;
+}
+
+template <typename Type, typename Other>
+bool operator!=( Counting_allocator<Type> const &, Counting_allocator<Other> const & ) {
+	return false;
+}
+
+/*
+ * The i-th key (see scattered_key() in Hash_functions.h).
+ */
+template <typename Type>
+Type key( long i ) {
+	return static_cast<Type>( scattered_key( i ) );
+}
+
+/*
+ * Times of the runs of one operation.
+ */
+class Timings {
+	private:
+		std::vector<double> per_call;   // ns per call of each run
+		double total_ns;
+		long calls;
+
+	public:
+		Timings():
+		total_ns( 0.0 ),
+		calls( 0 ) {
+			// empty constructor
+		}
+
+		void add( bench_clock::duration d, int n ) {
+			double ns = std::chrono::duration<double, std::nano>( d ).count();
+
+			per_call.push_back( ns / n );
+			total_ns += ns;
+			calls += n;
+		}
+
+		long count() const {
+			return calls;
+		}
+
+		double mean() const {
+			return (calls == 0) ? 0.0 : total_ns / calls;
+		}
+
+		double percentile( double p ) {
+			if ( per_call.empty() ) {
+				return 0.0;
+			}
+
+			std::size_t k = static_cast<std::size_t>( p * (per_call.size() - 1) + 0.5 );
+
+			std::nth_element( per_call.begin(), per_call.begin() + k, per_call.end() );
+
+			return per_call[k];
+		}
+};
+
+struct Result {
+	std::string type;
+	int power;
+	double load;
+	std::string op;
+	long calls;
+	double mean;
+	double p50;
+	double p90;
+	double p99;
+	double bytes;
+};
+
+/*
+ * Call f(i) for i in [0, n) in timed runs.
+ */
+template <typename Function>
+void timed( Timings &timings, long n, Function f ) {
+	for ( long first = 0; first < n; first += run ) {
+		long last = std::min( first + run, n );
+		bench_clock::time_point start = bench_clock::now();
+
+		for ( long i = first; i < last; ++i ) {
+			f( i );
+		}
+
+		timings.add( bench_clock::now() - start, static_cast<int>( last - first ) );
+	}
+}
+
+template <typename Type>
+class Benchmark {
+	private:
+		typedef Quadratic_hash_table<Type, Quadratic_probe, Default_hash<Type>, Counting_allocator<Type> > table_t;
+
+		std::string name;
+		int power;
+		double load;
+		long n;
+		int rounds;
+		int errors;
+
+		static long gcd( long a, long b ) {
+			return (b == 0) ? a : gcd( b, a % b );
+		}
+
+		// stride coprime to n, so that lookups do not follow insertion order
+		long stride() const {
+			long s = 40503 % n;
+
+			while ( s > 1 && gcd( s, n ) != 1 ) {
+				--s;
+			}
+
+			return std::max( s, 1L );
+		}
+
+		void fill( table_t &table ) const {
+			for ( long i = 0; i < n; ++i ) {
+				table.insert( key<Type>( i ) );
+			}
+		}
+
+		Result result( char const *op, Timings &t, double bytes ) const {
+			Result r = {name, power, load, op, t.count(), t.mean(),
+			            t.percentile( 0.50 ), t.percentile( 0.90 ), t.percentile( 0.99 ), bytes};
+
+			return r;
+		}
+
+	public:
+		Benchmark( char const *s, int p, double l ):
+		name( s ),
+		power( p ),
+		load( l ),
+		n( std::max( static_cast<long>( l * (1L << p) ), 1L ) ),
+		rounds( static_cast<int>( std::max( min_ops / n, 1L ) ) ),
+		errors( 0 ) {
+			// empty constructor
+		}
+
+		int error_count() const {
+			return errors;
+		}
+
+		void run( std::vector<Result> &results ) {
+			Timings insert, hit, miss, erase, churn;
+			long const step = stride();
+			double bytes = 0.0;
+
+			for ( int r = 0; r < rounds; ++r ) {
+				Storage::reset();
+
+				table_t table( power );
+
+				timed( insert, n, [&]( long i ) {
+					table.insert( key<Type>( i ) );
+				} );
+
+				bytes = static_cast<double>( Storage::peak ) / n;
+
+				long found = 0;
+				long j = 0;
+
+				// j runs through i * step modulo n without a division
+				timed( hit, n, [&]( long ) {
+					found += table.member( key<Type>( j ) );
+					j = (j + step < n) ? j + step : j + step - n;
+				} );
+
+				timed( miss, n, [&]( long i ) {
+					found -= table.member( key<Type>( n + i ) );
+				} );
+
+				if ( found != n ) {
+					++errors;
+				}
+
+				timed( erase, n, [&]( long ) {
+					table.erase( key<Type>( j ) );
+					j = (j + step < n) ? j + step : j + step - n;
+				} );
+
+				if ( !table.empty() ) {
+					++errors;
+				}
+			}
+
+			// churn keeps n keys: erase key i and insert key n + i
+			for ( int r = 0; r < rounds; ++r ) {
+				table_t table( power );
+
+				table.max_erased_ratio( std::max( (1.0 - load) / 2, 1.0 / (1 << power) ) );
+				fill( table );
+
+				timed( churn, n, [&]( long i ) {
+					table.erase( key<Type>( i ) );
+					table.insert( key<Type>( n + i ) );
+				} );
+
+				if ( table.size() != n ) {
+					++errors;
+				}
+			}
+
+			results.push_back( result( "insert", insert, bytes ) );
+			results.push_back( result( "hit", hit, bytes ) );
+			results.push_back( result( "miss", miss, bytes ) );
+			results.push_back( result( "erase", erase, bytes ) );
+			results.push_back( result( "churn", churn, bytes ) );
+		}
+};
+
+void print_header( std::ostream &out ) {
+	out << "type    power  load  op          calls      ns/op      p50      p90      p99  bytes/elem" << std::endl;
+}
+
+void print( std::ostream &out, Result const &r ) {
+	out << std::left << std::setw( 8 ) << r.type << std::right
+	    << std::setw( 5 ) << r.power
+	    << std::setw( 6 ) << std::fixed << std::setprecision( 2 ) << r.load << "  "
+	    << std::left << std::setw( 7 ) << r.op << std::right
+	    << std::setw( 11 ) << r.calls
+	    << std::setw( 11 ) << std::setprecision( 1 ) << r.mean
+	    << std::setw( 9 ) << r.p50
+	    << std::setw( 9 ) << r.p90
+	    << std::setw( 9 ) << r.p99
+	    << std::setw( 12 ) << std::setprecision( 2 ) << r.bytes << std::endl;
+}
+
+void print_csv_header( std::ostream &out ) {
+	out << "type,power,load,op,calls,ns_per_op,p50_ns,p90_ns,p99_ns,bytes_per_element" << std::endl;
+}
+
+void print_csv( std::ostream &out, Result const &r ) {
+	out << r.type << ',' << r.power << ',' << r.load << ',' << r.op << ',' << r.calls << ','
+	    << r.mean << ',' << r.p50 << ',' << r.p90 << ',' << r.p99 << ',' << r.bytes << std::endl;
+}
+
+int usage( char const *program ) {
+	std::cerr << "Usage: " << program << " [--type int|double|all] [--powers MIN:MAX[:STEP]]"
+	          << " [--loads L1,L2,...] [--csv FILE]" << std::endl;
+
+	return -1;
+}
+
+int main( int argc, char *argv[] ) {
+	std::string type = "all";
+	int min_power = 10;
+	int max_power = 26;
+	int step = 2;
+	std::vector<double> loads;
+	char const *csv = 0;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( i + 1 == argc ) {
+			return usage( argv[0] );
+		}
+
+		std::string option = argv[i];
+		std::string value = argv[++i];
+
+		if ( option == "--type" && (value == "int" || value == "double" || value == "all") ) {
+			type = value;
+		} else if ( option == "--powers" ) {
+			char colon;
+			std::istringstream in( value );
+
+			if ( !(in >> min_power >> colon >> max_power) || colon != ':' ) {
+				return usage( argv[0] );
+			}
+
+			if ( !(in >> colon >> step) ) {
+				step = 1;
+			}
+		} else if ( option == "--loads" ) {
+			std::istringstream in( value );
+			double load;
+
+			while ( in >> load ) {
+				loads.push_back( load );
+				in.ignore( 1 );
+			}
+		} else if ( option == "--csv" ) {
+			csv = argv[i];
+		} else {
+			return usage( argv[0] );
+		}
+	}
+
+	if ( loads.empty() ) {
+		double const defaults[] = {0.25, 0.5, 0.75, 0.9, 0.95};
+
+		loads.assign( defaults, defaults + 5 );
+	}
+
+	if ( min_power < 1 || max_power > 29 || min_power > max_power || step < 1 ) {
+		return usage( argv[0] );
+	}
+
+	for ( std::size_t i = 0; i < loads.size(); ++i ) {
+		if ( !(loads[i] > 0.0 && loads[i] < 1.0) ) {
+			std::cerr << "Load factors must be in (0, 1)" << std::endl;
+
+			return -1;
+		}
+	}
+
+	bool text = (csv == 0 || std::strcmp( csv, "-" ) != 0);
+	std::ofstream file;
+	std::ostream *table_out = text ? &std::cout : 0;
+	std::ostream *csv_out = 0;
+
+	if ( csv != 0 && !text ) {
+		csv_out = &std::cout;
+	} else if ( csv != 0 ) {
+		file.open( csv );
+
+		if ( !file ) {
+			std::cerr << "Cannot write " << csv << std::endl;
+
+			return -1;
+		}
+
+		csv_out = &file;
+	}
+
+	if ( table_out != 0 ) {
+		print_header( *table_out );
+	}
+
+	if ( csv_out != 0 ) {
+		print_csv_header( *csv_out );
+	}
+
+	int errors = 0;
+
+	for ( int p = min_power; p <= max_power; p += step ) {
+		for ( std::size_t l = 0; l < loads.size(); ++l ) {
+			std::vector<Result> results;
+
+			if ( type != "double" ) {
+				Benchmark<int> bench( "int", p, loads[l] );
+
+				bench.run( results );
+				errors += bench.error_count();
+			}
+
+			if ( type != "int" ) {
+				Benchmark<double> bench( "double", p, loads[l] );
+
+				bench.run( results );
+				errors += bench.error_count();
+			}
+
+			for ( std::size_t r = 0; r < results.size(); ++r ) {
+				if ( table_out != 0 ) {
+					print( *table_out, results[r] );
+				}
+
+				if ( csv_out != 0 ) {
+					print_csv( *csv_out, results[r] );
+				}
+			}
+		}
+	}
+
+	if ( errors != 0 ) {
+		std::cerr << errors << " benchmark runs returned wrong results" << std::endl;
+
+		return 1;
+	}
+
+	return 0;
+}
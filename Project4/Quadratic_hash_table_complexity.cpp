@@ -0,0 +1,255 @@
+/****************************************************
+ * Executable:   Quadratic_hash_table_complexity
+ * Author:  Keshav Kanatala
+ *
+ * A gate that fails if an operation of Quadratic_hash_table stops
+ * taking constant expected time.
+ *
+ *   Quadratic_hash_table_complexity [--min-power P] [--max-power P]
+ *                                   [--runs R] [--full]
+ *
+ * For each n = 2^P, doubling from 2^10 to 2^18 by default, a table
+ * with a maximum load factor of 0.75 and a maximum erased ratio of
+ * 0.25 is built from its default capacity, and these are timed over
+ * n calls each:
+ *
+ *   insert   inserting n keys (the table grows as it fills)
+ *   hit      member() of present keys
+ *   miss     member() of absent keys
+ *   erase    erasing half of the keys
+ *   churn    member() of absent keys after the erasures, with the
+ *            erased bins still in place
+ *
+ * Every size is run R times (by default 7).  The median cost per call
+ * of each size is printed, and ece250::growth_tester() fits the
+ * exponent k of cost ~ n^k through all runs.  An operation fails if
+ * the whole 95% confidence interval of k is above 0.25, or if its
+ * median cost at the largest n is more than 4 times that at the
+ * smallest: constant cost gives k near 0 (a little above it once the
+ * table outgrows the caches), and a scan of the table gives k near 1.
+ *
+ * --full fills tables of exactly n bins to capacity instead (up to
+ * 2^14 by default), where a miss must scan every bin; the gate is then
+ * expected to fail, which checks the gate itself.
+ *
+ * The exit status is 1 if any operation failed.
+ ****************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Quadratic_hash_table.h"
+
+typedef Quadratic_hash_table<int> table_t;
+
+int const n_ops = 5;
+char const *const op_names[n_ops] = {"insert", "hit", "miss", "erase", "churn"};
+
+// the largest exponent k of cost ~ n^k tolerated above 0
+double const tolerance = 0.25;
+
+// the largest ratio of the median cost at the largest n to that at the smallest
+double const max_growth = 4.0;
+
+/*
+ * Nanoseconds per call of the last interval timed by watch.
+ */
+double per_call( ece250::Stopwatch const &watch, int calls ) {
+	return static_cast<double>( watch.get_last_nanoseconds() ) / calls;
+}
+
+/*
+ * Time each operation once at size n; cost[op] is set to the
+ * nanoseconds per call.  Returns false if a lookup gave a wrong answer.
+ */
+bool run_once( int power, bool full, double *cost ) {
+	int n = 1 << power;
+	table_t *table;
+
+	if ( full ) {
+		table = new table_t( power );
+	} else {
+		table = new table_t();
+		table->max_load_factor( 0.75 );
+		table->max_erased_ratio( 0.25 );
+	}
+
+	int found = 0;
+	ece250::Stopwatch watch;
+
+	watch.start();
+
+	for ( int i = 0; i < n; ++i ) {
+		table->insert( scattered_key( i ) );
+	}
+
+	watch.stop();
+	cost[0] = per_call( watch, n );
+
+	watch.start();
+
+	for ( int i = 0; i < n; ++i ) {
+		found += table->member( scattered_key( i ) );
+	}
+
+	watch.stop();
+	cost[1] = per_call( watch, n );
+
+	watch.start();
+
+	for ( int i = 0; i < n; ++i ) {
+		found -= table->member( scattered_key( n + i ) );
+	}
+
+	watch.stop();
+	cost[2] = per_call( watch, n );
+
+	watch.start();
+
+	for ( int i = 0; i < n; i += 2 ) {
+		table->erase( scattered_key( i ) );
+	}
+
+	watch.stop();
+	cost[3] = per_call( watch, n / 2 );
+
+	watch.start();
+
+	for ( int i = 0; i < n; ++i ) {
+		found -= table->member( scattered_key( n + i ) );
+	}
+
+	watch.stop();
+	cost[4] = per_call( watch, n );
+
+	bool correct = (found == n) && (table->size() == n / 2);
+
+	delete table;
+
+	return correct;
+}
+
+int usage( char const *program ) {
+	std::cerr << "Usage: " << program << " [--min-power P] [--max-power P] [--runs R] [--full]" << std::endl;
+
+	return -1;
+}
+
+int main( int argc, char *argv[] ) {
+	int min_power = 10;
+	int max_power = 0;
+	int runs = 7;
+	bool full = false;
+
+	for ( int i = 1; i < argc; ++i ) {
+		if ( !std::strcmp( argv[i], "--full" ) ) {
+			full = true;
+		} else if ( i + 1 < argc && !std::strcmp( argv[i], "--min-power" ) ) {
+			min_power = std::atoi( argv[++i] );
+		} else if ( i + 1 < argc && !std::strcmp( argv[i], "--max-power" ) ) {
+			max_power = std::atoi( argv[++i] );
+		} else if ( i + 1 < argc && !std::strcmp( argv[i], "--runs" ) ) {
+			runs = std::atoi( argv[++i] );
+		} else {
+			return usage( argv[0] );
+		}
+	}
+
+	if ( max_power == 0 ) {
+		// misses in a full table are quadratic in total
+		max_power = full ? 14 : 18;
+	}
+
+	if ( min_power < 4 || max_power > 26 || max_power - min_power < 2 || runs < 1 ) {
+		return usage( argv[0] );
+	}
+
+	int sizes = max_power - min_power + 1;
+	std::vector<double> n;
+	std::vector<std::vector<double> > cost( n_ops );
+	std::vector<std::vector<double> > medians( n_ops, std::vector<double>( sizes ) );
+	bool correct = true;
+
+	for ( int p = min_power; p <= max_power; ++p ) {
+		std::vector<std::vector<double> > samples( n_ops );
+
+		for ( int r = 0; r < runs; ++r ) {
+			double once[n_ops];
+
+			correct = run_once( p, full, once ) && correct;
+			n.push_back( 1 << p );
+
+			for ( int op = 0; op < n_ops; ++op ) {
+				cost[op].push_back( once[op] );
+				samples[op].push_back( once[op] );
+			}
+		}
+
+		for ( int op = 0; op < n_ops; ++op ) {
+			medians[op][p - min_power] = ece250::median( &samples[op][0], runs );
+		}
+	}
+
+	std::cout << "Median ns per call (" << runs << " runs per size"
+	          << (full ? ", tables filled to capacity" : "") << "):" << std::endl;
+	std::cout << "  power";
+
+	for ( int op = 0; op < n_ops; ++op ) {
+		std::cout << std::setw( 10 ) << op_names[op];
+	}
+
+	std::cout << std::endl << std::fixed << std::setprecision( 1 );
+
+	for ( int p = min_power; p <= max_power; ++p ) {
+		std::cout << std::setw( 7 ) << p;
+
+		for ( int op = 0; op < n_ops; ++op ) {
+			std::cout << std::setw( 10 ) << medians[op][p - min_power];
+		}
+
+		std::cout << std::endl;
+	}
+
+	std::cout << std::endl << "Fitted growth of the cost per call, n^k with 95% interval," << std::endl
+	          << "and x, the median at the largest n over that at the smallest:" << std::endl;
+	std::cout << std::setprecision( 3 );
+
+	int failures = 0;
+
+	for ( int op = 0; op < n_ops; ++op ) {
+		ece250::Growth_fit fit;
+		bool passed = ece250::growth_tester( &n[0], &cost[op][0], static_cast<int>( n.size() ),
+		                                     0.0, tolerance, &fit );
+		double growth = medians[op][sizes - 1] / medians[op][0];
+
+		passed = passed && growth <= max_growth;
+
+		std::cout << "  " << std::left << std::setw( 8 ) << op_names[op] << std::right
+		          << " k = " << std::setw( 6 ) << fit.exponent
+		          << "  [" << fit.low << ", " << fit.high << "]"
+		          << "  x" << std::setw( 8 ) << growth << "  "
+		          << (passed ? "ok" : "FAILED: the cost grows with n") << std::endl;
+
+		if ( !passed ) {
+			++failures;
+		}
+	}
+
+	if ( !correct ) {
+		std::cout << "FAILED: a lookup returned a wrong answer" << std::endl;
+	}
+
+	if ( failures != 0 || !correct ) {
+		std::cerr << "COMPLEXITY GATE FAILED: " << failures
+		          << " operation(s) are no longer constant expected time" << std::endl;
+
+		return 1;
+	}
+
+	std::cout << "Complexity gate passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,915 @@
+/****************************************************
+ * Executable:   Quadratic_hash_table_features
+ * Author:  Keshav Kanatala
+ *
+ * Check the parts of Quadratic_hash_table that the tester scripts
+ * cannot reach, because the tester only drives the default table.
+ *
+ *   Quadratic_hash_table_features [check ...]
+ *       Run the named checks (by default all of them), print the
+ *       number of errors found by each and exit with 1 if there
+ *       were any:
+ *
+ *       probes      every probe policy visits each group of a table
+ *                   exactly once, and a table using it agrees with a
+ *                   std::set through inserts, erases, resizing and
+ *                   compaction, and overflows only when full
+ *       hashes      each hash function keeps strided and negative keys
+ *                   in range and apart, honours its seed, and hashes
+ *                   doubles by value (-0.0 as 0.0, fractions apart)
+ *       map         Quadratic_hash_map agrees with a std::map through
+ *                   try_emplace, insert_or_assign, [], find and erase
+ *                   while it grows from a small table
+ *       batch       member_batch, insert_batch and erase_batch report
+ *                   the same per-key results as one call per key, for
+ *                   batches of every length up to 200 with repeated
+ *                   keys, and keep what they inserted before overflow
+ *       build       build() from ranges with duplicates, crowded home
+ *                   bins and every kind of iterator, on one thread and
+ *                   on several, gives the same set as insert()
+ *       image       a saved table, also one saved in the middle of a
+ *                   resize, opens as an image with the same entries,
+ *                   and open() rejects images of another probe or
+ *                   hash, truncated files and (if verifying) any
+ *                   corrupted byte
+ *       iterators   iterating over tables of every capacity from 1 to
+ *                   2^12 bins, with erased bins and a resize in
+ *                   progress, visits each entry exactly once
+ *       arena       an Arena hands out aligned, disjoint blocks, reuses
+ *                   the last block given back and one slab after
+ *                   release(), and tables growing side by side on one
+ *                   arena agree with a std::set
+ ****************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "Quadratic_hash_table.h"
+#include "Quadratic_hash_table_image.h"
+#include "Quadratic_hash_map.h"
+
+/*
+ * Count the groups of a table of 2^power groups that the sequence of
+ * Probe does not visit exactly once in its first 2^power steps.
+ */
+template <typename Probe>
+int unvisited_groups( int power, int home, std::size_t code ) {
+	int groups = 1 << power;
+	std::vector<int> visits( groups, 0 );
+	typename Probe::sequence seq( home & (groups - 1), code, groups - 1 );
+
+	for ( int i = 0; i < groups; ++i ) {
+		++visits[seq.position()];
+		seq.next();
+	}
+
+	int errors = 0;
+
+	for ( int i = 0; i < groups; ++i ) {
+		errors += visits[i] != 1;
+	}
+
+	return errors;
+}
+
+/*
+ * Insert, erase and look up random keys in a table using Probe and
+ * compare every result with a std::set.  Mode 0 never resizes or
+ * compacts, mode 1 compacts, mode 2 also resizes from a small table.
+ */
+template <typename Probe>
+int random_operations( int mode ) {
+	Quadratic_hash_table<int, Probe> table( (mode == 2) ? 2 : 10 );
+	std::set<int> expected;
+	int range = (mode == 2) ? 5000 : 600;
+	int errors = 0;
+
+	if ( mode >= 1 ) {
+		table.max_erased_ratio( 0.2 );
+	}
+
+	if ( mode == 2 ) {
+		table.max_load_factor( 0.6 );
+	}
+
+	std::srand( 1 + mode );
+
+	for ( int i = 0; i < 100000; ++i ) {
+		int key = std::rand() % range - 50;
+
+		switch ( std::rand() % 3 ) {
+			case 0:
+				if ( table.size() < table.capacity() ) {
+					table.insert( key );
+					expected.insert( key );
+				}
+
+				break;
+			case 1:
+				errors += table.erase( key ) != (expected.erase( key ) > 0);
+				break;
+			default:
+				errors += table.member( key ) != (expected.count( key ) > 0);
+				break;
+		}
+	}
+
+	errors += table.size() != static_cast<int>( expected.size() );
+
+	for ( std::set<int>::const_iterator itr = expected.begin(); itr != expected.end(); ++itr ) {
+		errors += !table.member( *itr );
+	}
+
+	return errors;
+}
+
+/*
+ * A table that does not resize must hold exactly its capacity of keys
+ * that share one home bin, and then throw overflow.
+ */
+template <typename Probe>
+int fill_to_capacity() {
+	Quadratic_hash_table<int, Probe> table( 4 );
+	int errors = 0;
+
+	for ( int i = 0; i < 16; ++i ) {
+		table.insert( 16*i );
+	}
+
+	for ( int i = 0; i < 16; ++i ) {
+		errors += !table.member( 16*i );
+	}
+
+	try {
+		table.insert( 1 );
+		++errors;
+	} catch ( overflow ) {
+		// expected
+	}
+
+	return errors;
+}
+
+template <typename Probe>
+int check_probe() {
+	int errors = 0;
+
+	for ( int power = 0; power <= 10; ++power ) {
+		for ( int home = 0; home < 64; home += 7 ) {
+			errors += unvisited_groups<Probe>( power, home, 0x9E3779B9u * (home + 1) );
+		}
+	}
+
+	for ( int mode = 0; mode < 3; ++mode ) {
+		errors += random_operations<Probe>( mode );
+	}
+
+	return errors + fill_to_capacity<Probe>();
+}
+
+int check_probes() {
+	return check_probe<Quadratic_probe>()
+	     + check_probe<Linear_probe>()
+	     + check_probe<Double_hash_probe>()
+	     + check_probe< Group_probe<Quadratic_probe> >()
+	     + check_probe< Group_probe<Linear_probe> >()
+	     + check_probe< Group_probe<Double_hash_probe> >();
+}
+
+/*
+ * Insert the keys 0, stride, 2*stride, ... and their negatives into a
+ * table using Hash and check that every home bin is in range, that
+ * the keys occupy at least 'spread' distinct home bins, and that all
+ * of them are found.
+ */
+template <typename Hash>
+int strided_keys( int stride, int spread, Hash const &hasher = Hash() ) {
+	Quadratic_hash_table<int, Quadratic_probe, Hash> table( 10, hasher );
+	std::set<int> homes;
+	int errors = 0;
+
+	for ( int i = 0; i < 256; ++i ) {
+		for ( int sign = -1; sign <= 1; sign += 2 ) {
+			int key = sign * i * stride;
+			int home = table.hash( key );
+
+			errors += home < 0 || home >= table.capacity();
+			homes.insert( home );
+
+			if ( !table.member( key ) ) {
+				table.insert( key );
+			}
+		}
+	}
+
+	errors += static_cast<int>( homes.size() ) < spread;
+
+	for ( int i = 0; i < 256; ++i ) {
+		errors += !table.member( i * stride ) + !table.member( -i * stride );
+	}
+
+	return errors;
+}
+
+/*
+ * A hash function constructed with a seed must report it and, for the
+ * mixing functions, change the codes.
+ */
+template <typename Hash>
+int seeded( bool mixes ) {
+	Hash plain;
+	Hash salted( 12345 );
+	int same = 0;
+
+	for ( int key = 0; key < 64; ++key ) {
+		same += plain( key ) == salted( key );
+	}
+
+	return (plain.seed() != 0) + (salted.seed() != 12345) + (mixes && same > 0);
+}
+
+int check_hashes() {
+	int errors = 0;
+
+	// the identity keeps the placement of the original hash()
+	Quadratic_hash_table<int> identity( 5 );
+
+	for ( int key = -100; key <= 100; ++key ) {
+		errors += identity.hash( key ) != (key & 31);
+	}
+
+	// strided keys all share a home under the identity but not otherwise
+	errors += strided_keys< Identity_hash<int> >( 1, 256 );
+	errors += strided_keys< Identity_hash<int> >( 1024, 1 );
+	errors += strided_keys< Fibonacci_hash<int> >( 1024, 256 );
+	errors += strided_keys< Murmur_hash<int> >( 1024, 256 );
+	errors += strided_keys< Murmur_hash<int> >( 1024, 256, Murmur_hash<int>( 99 ) );
+
+	errors += seeded< Identity_hash<int> >( true );
+	errors += seeded< Fibonacci_hash<int> >( true );
+	errors += seeded< Murmur_hash<int> >( true );
+	errors += seeded< Float_hash<double> >( true );
+
+	// doubles are hashed by value, not truncated to an integer
+	Quadratic_hash_table<double> doubles( 12 );
+	Float_hash<double> float_hash;
+	double zero = 0.0;
+	std::set<int> homes;
+
+	for ( int i = 0; i < 1000; ++i ) {
+		doubles.insert( i / 1000.0 );
+		homes.insert( doubles.hash( i / 1000.0 ) );
+	}
+
+	errors += homes.size() < 500;
+	errors += doubles.size() != 1000;
+	errors += float_hash( -zero ) != float_hash( zero );
+	errors += !doubles.member( -zero );
+	errors += float_hash( zero / zero ) != float_hash( -(zero / zero) );
+
+	for ( int i = 0; i < 1000; ++i ) {
+		errors += !doubles.member( i / 1000.0 );
+	}
+
+	return errors;
+}
+
+std::string value_of( int n ) {
+	std::ostringstream out;
+
+	out << "value " << n;
+
+	return out.str();
+}
+
+int check_map() {
+	Quadratic_hash_map<int, std::string> map( 2 );
+	std::map<int, std::string> expected;
+	int errors = 0;
+
+	std::srand( 6 );
+
+	for ( int i = 0; i < 100000; ++i ) {
+		int key = std::rand() % 3000;
+		std::string value = value_of( std::rand() % 100 );
+
+		switch ( std::rand() % 5 ) {
+			case 0: {
+				std::pair<std::string *, bool> result = map.try_emplace( key, value );
+				bool inserted = expected.insert( std::make_pair( key, value ) ).second;
+
+				errors += result.second != inserted || *result.first != expected[key];
+				break;
+			}
+			case 1:
+				errors += map.insert_or_assign( key, value ) != (expected.count( key ) == 0);
+				expected[key] = value;
+				break;
+			case 2:
+				map[key] += "!";
+				expected[key] += "!";
+				break;
+			case 3:
+				errors += map.erase( key ) != (expected.erase( key ) > 0);
+				break;
+			default: {
+				std::string const *found = static_cast<Quadratic_hash_map<int, std::string> const &>( map ).find( key );
+				std::map<int, std::string>::const_iterator itr = expected.find( key );
+
+				errors += (found == 0) != (itr == expected.end());
+				errors += found != 0 && itr != expected.end() && *found != itr->second;
+				errors += map.member( key ) != (itr != expected.end());
+				break;
+			}
+		}
+	}
+
+	errors += map.size() != static_cast<int>( expected.size() );
+	errors += map.load_factor() > 0.75;
+
+	for ( std::map<int, std::string>::const_iterator itr = expected.begin(); itr != expected.end(); ++itr ) {
+		std::string *found = map.find( itr->first );
+
+		errors += found == 0 || *found != itr->second;
+	}
+
+	return errors;
+}
+
+bool bit( unsigned long long const *bitmap, int i ) {
+	return (bitmap[i / 64] >> (i % 64)) & 1;
+}
+
+int check_batch() {
+	Quadratic_hash_table<int> table( 3 );
+	std::set<int> expected;
+	int keys[200];
+	unsigned long long bitmap[4];
+	int errors = 0;
+
+	table.max_load_factor( 0.75 );
+	table.max_erased_ratio( 0.25 );
+	std::srand( 8 );
+
+	for ( int i = 0; i < 3000; ++i ) {
+		int n = i % 201;
+		int count = 0;
+
+		for ( int j = 0; j < n; ++j ) {
+			keys[j] = std::rand() % 2000;
+		}
+
+		switch ( i % 3 ) {
+			case 0:
+				count = table.insert_batch( keys, n, bitmap );
+
+				for ( int j = 0; j < n; ++j ) {
+					bool inserted = expected.insert( keys[j] ).second;
+
+					errors += bit( bitmap, j ) != inserted;
+					count -= inserted;
+				}
+
+				errors += count != 0;
+				break;
+			case 1:
+				count = table.erase_batch( keys, n, bitmap );
+
+				for ( int j = 0; j < n; ++j ) {
+					bool erased = expected.erase( keys[j] ) > 0;
+
+					errors += bit( bitmap, j ) != erased;
+					count -= erased;
+				}
+
+				errors += count != 0;
+				break;
+			default:
+				count = table.member_batch( keys, n, bitmap );
+
+				for ( int j = 0; j < n; ++j ) {
+					bool found = expected.count( keys[j] ) > 0;
+
+					errors += bit( bitmap, j ) != found;
+					count -= found;
+				}
+
+				errors += count != 0;
+				break;
+		}
+
+		errors += table.size() != static_cast<int>( expected.size() );
+	}
+
+	// a table that does not resize keeps the keys inserted before it filled
+	Quadratic_hash_table<int> full( 4 );
+
+	for ( int j = 0; j < 20; ++j ) {
+		keys[j] = j;
+	}
+
+	try {
+		full.insert_batch( keys, 20, bitmap );
+		++errors;
+	} catch ( overflow ) {
+		errors += full.size() != 16;
+
+		for ( int j = 0; j < 16; ++j ) {
+			errors += !full.member( j );
+		}
+	}
+
+	return errors;
+}
+
+/*
+ * Build a table of Probe from [first, last) on the given number of
+ * threads and compare it with the set of the same keys.
+ */
+template <typename Probe, typename Iterator>
+int built_table( Iterator first, Iterator last, int threads ) {
+	Quadratic_hash_table<int, Probe> table( 5 );
+	std::set<int> expected( first, last );
+	int errors = 0;
+
+	table.insert( -1 );
+	table.build( first, last, threads );
+
+	errors += table.size() != static_cast<int>( expected.size() );
+	errors += table.load_factor() > 0.5;
+	errors += table.member( -1 ) != (expected.count( -1 ) > 0);
+
+	for ( Iterator itr = first; itr != last; ++itr ) {
+		errors += !table.member( *itr );
+	}
+
+	// the table still takes ordinary inserts
+	for ( int i = 0; i < 1000; ++i ) {
+		table.insert( -2 - i );
+		errors += !table.member( -2 - i );
+	}
+
+	return errors;
+}
+
+template <typename Probe>
+int check_build_probe() {
+	int const n = 1 << 17;
+	std::vector<int> random_keys( n );
+	std::vector<int> runs( n );
+	std::vector<int> crowded( n );
+	int errors = 0;
+
+	std::srand( 12 );
+
+	for ( int i = 0; i < n; ++i ) {
+		// about one key in eight is a duplicate
+		random_keys[i] = std::rand() % (7*n);
+		// runs of consecutive keys fill the regions up to their edges
+		runs[i] = i;
+		crowded[i] = random_keys[i];
+	}
+
+	// sixteen keys share the last bin before each multiple of 2^14,
+	// so some of them leave their region
+	for ( int i = 0; i < 16*64; ++i ) {
+		crowded[i] = ((i / 16 + 1) << 14) - 1 + (i % 16) * (1 << 24);
+	}
+
+	for ( int threads = 1; threads <= 4; threads *= 2 ) {
+		errors += built_table<Probe>( random_keys.begin(), random_keys.end(), threads );
+		errors += built_table<Probe>( runs.begin(), runs.end(), threads );
+		errors += built_table<Probe>( crowded.begin(), crowded.end(), threads );
+	}
+
+	std::list<int> small( random_keys.begin(), random_keys.begin() + 5000 );
+
+	return errors + built_table<Probe>( small.begin(), small.end(), 4 );
+}
+
+int check_build() {
+	return check_build_probe<Quadratic_probe>()
+	     + check_build_probe<Linear_probe>()
+	     + check_build_probe< Group_probe<Double_hash_probe> >();
+}
+
+/*
+ * The contents of the file at path.
+ */
+std::vector<char> read_file( char const *path ) {
+	std::ifstream in( path, std::ios::binary );
+
+	return std::vector<char>( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+}
+
+void write_file( char const *path, std::vector<char> const &bytes ) {
+	std::ofstream out( path, std::ios::binary | std::ios::trunc );
+
+	out.write( &bytes[0], bytes.size() );
+}
+
+/*
+ * Open the image at path as a table of Probe and Hash and compare it
+ * with the keys in [0, range) that are in expected.
+ */
+template <typename Probe, typename Hash>
+int opened_image( char const *path, std::set<int> const &expected, int range, int capacity ) {
+	Quadratic_hash_table_image<int, Probe, Hash> image;
+	int errors = 0;
+
+	if ( !image.open( path ) ) {
+		return 1;
+	}
+
+	errors += image.size() != static_cast<int>( expected.size() );
+	errors += image.capacity() != capacity;
+
+	for ( int key = -range; key < range; ++key ) {
+		errors += image.member( key ) != (expected.count( key ) > 0);
+	}
+
+	return errors;
+}
+
+/*
+ * Save a table of Probe and Hash after random inserts and erases, and
+ * once in the middle of a resize, and open the images; then damage
+ * the last image and check that open() rejects it.
+ */
+template <typename Probe, typename Hash, typename Other_probe, typename Other_hash>
+int check_image_table( char const *path, Hash const &hasher ) {
+	int const range = 4000;
+	Quadratic_hash_table<int, Probe, Hash> table( 4, hasher );
+	std::set<int> expected;
+	int errors = 0;
+
+	table.max_load_factor( 0.75 );
+
+	errors += !table.save( path );
+	errors += opened_image<Probe, Hash>( path, expected, range, table.capacity() );
+
+	std::srand( 13 );
+
+	for ( int i = 0; i < 20000; ++i ) {
+		int key = std::rand() % range;
+
+		if ( std::rand() % 3 ) {
+			table.insert( key );
+			expected.insert( key );
+		} else {
+			table.erase( key );
+			expected.erase( key );
+		}
+	}
+
+	errors += !table.save( path );
+	errors += opened_image<Probe, Hash>( path, expected, range, table.capacity() );
+
+	// the resize is completed by save()
+	while ( !table.resizing() ) {
+		int key = -1 - static_cast<int>( expected.size() );
+
+		table.insert( key );
+		expected.insert( key );
+	}
+
+	errors += !table.save( path );
+	errors += opened_image<Probe, Hash>( path, expected, range, table.capacity() );
+
+	Quadratic_hash_table_image<int, Probe, Hash> image;
+	Quadratic_hash_table_image<int, Other_probe, Hash> other_probe;
+	Quadratic_hash_table_image<int, Probe, Other_hash> other_hash;
+	Quadratic_hash_table_image<long long, Probe, Hash> other_type;
+
+	errors += other_probe.open( path, false ) || other_hash.open( path, false ) || other_type.open( path, false );
+
+	std::vector<char> bytes = read_file( path );
+	Table_image_header header;
+
+	std::memcpy( &header, &bytes[0], sizeof( header ) );
+
+	std::vector<char> damaged( bytes );
+
+	damaged.back() ^= 1;
+	write_file( path, damaged );
+	errors += image.open( path ) || !image.open( path, false );
+
+	damaged = bytes;
+	damaged[header.control_offset] ^= 1;
+	write_file( path, damaged );
+	errors += image.open( path );
+
+	damaged = bytes;
+	damaged[offsetof( Table_image_header, seed )] ^= 1;
+	write_file( path, damaged );
+	errors += image.open( path );
+
+	damaged = bytes;
+	damaged.pop_back();
+	write_file( path, damaged );
+	errors += image.open( path, false );
+
+	damaged.resize( sizeof( header ) - 1 );
+	write_file( path, damaged );
+	errors += image.open( path, false );
+
+	write_file( path, bytes );
+	errors += !image.open( path ) || image.size() != static_cast<int>( expected.size() );
+
+	image.close();
+	errors += image.is_open() || image.member( -1 );
+
+	return errors;
+}
+
+int check_image() {
+	char path[] = "/tmp/Quadratic_hash_table_features.XXXXXX";
+	int fd = mkstemp( path );
+	int errors = 0;
+
+	if ( fd == -1 ) {
+		std::cerr << "Cannot create a temporary file" << std::endl;
+
+		return 1;
+	}
+
+	close( fd );
+
+	errors += check_image_table<Quadratic_probe, Murmur_hash<int>, Linear_probe, Fibonacci_hash<int> >( path, Murmur_hash<int>( 7 ) );
+	errors += check_image_table<Linear_probe, Identity_hash<int>, Quadratic_probe, Murmur_hash<int> >( path, Identity_hash<int>() );
+	errors += check_image_table< Group_probe<Double_hash_probe>, Fibonacci_hash<int>, Double_hash_probe, Identity_hash<int> >( path, Fibonacci_hash<int>( 3 ) );
+
+	std::remove( path );
+
+	Quadratic_hash_table_image<int> missing;
+
+	return errors + missing.open( path, false );
+}
+
+/*
+ * Walk a table of Probe from begin() to end() and check that every
+ * entry of expected is visited exactly once, in bin order.
+ */
+template <typename Probe>
+int iterated_table( Quadratic_hash_table<int, Probe> const &table, std::set<int> const &expected ) {
+	typedef typename Quadratic_hash_table<int, Probe>::const_iterator iterator;
+	std::set<int> visited;
+	int const *previous = nullptr;
+	int errors = 0;
+
+	for ( iterator itr = table.begin(); itr != table.end(); ++itr ) {
+		errors += !visited.insert( *itr ).second;
+		errors += previous != nullptr && !(previous < &*itr);
+		previous = itr.operator->();
+	}
+
+	errors += visited != expected;
+	errors += std::distance( table.begin(), table.end() ) != table.size();
+
+	return errors;
+}
+
+template <typename Probe>
+int check_iterators_probe() {
+	int errors = 0;
+
+	std::srand( 14 );
+
+	for ( int power = 0; power <= 12; ++power ) {
+		Quadratic_hash_table<int, Probe> table( power );
+		std::set<int> expected;
+		int capacity = table.capacity();
+
+		errors += table.begin() != table.end();
+
+		// fill the table, then erase about half of it
+		for ( int i = 0; i < capacity; ++i ) {
+			int key = std::rand() % (4*capacity);
+
+			if ( !table.member( key ) ) {
+				table.insert( key );
+				expected.insert( key );
+			}
+		}
+
+		errors += iterated_table( table, expected );
+
+		for ( int i = 0; i < capacity; ++i ) {
+			int key = std::rand() % (4*capacity);
+
+			table.erase( key );
+			expected.erase( key );
+		}
+
+		errors += iterated_table( table, expected );
+
+		// begin() finishes a resize in progress
+		table.max_load_factor( 0.5 );
+
+		while ( !table.resizing() ) {
+			int key = -1 - static_cast<int>( expected.size() );
+
+			table.insert( key );
+			expected.insert( key );
+		}
+
+		errors += iterated_table( table, expected );
+		errors += table.resizing();
+
+		typename Quadratic_hash_table<int, Probe>::const_iterator itr = table.begin();
+		typename Quadratic_hash_table<int, Probe>::const_iterator first = itr++;
+
+		errors += first != table.begin() || (itr == first);
+	}
+
+	return errors;
+}
+
+int check_iterators() {
+	return check_iterators_probe<Quadratic_probe>()
+	     + check_iterators_probe< Group_probe<Linear_probe> >();
+}
+
+/*
+ * Allocate blocks of 0 to 99 bytes from an arena with small slabs and
+ * check that they are aligned, do not overlap and are counted.
+ */
+int arena_blocks( Arena &arena ) {
+	std::vector<unsigned char *> blocks;
+	std::size_t used = 0;
+	int errors = 0;
+
+	for ( int bytes = 0; bytes < 100; ++bytes ) {
+		unsigned char *block = static_cast<unsigned char *>( arena.allocate( bytes ) );
+
+		errors += reinterpret_cast<std::size_t>( block ) % 16 != 0;
+		std::memset( block, bytes, bytes );
+		blocks.push_back( block );
+		used += (bytes == 0) ? 16 : (bytes + 15)/16*16;
+	}
+
+	for ( int bytes = 0; bytes < 100; ++bytes ) {
+		for ( int i = 0; i < bytes; ++i ) {
+			errors += blocks[bytes][i] != bytes;
+		}
+	}
+
+	return errors + (arena.used() != used) + (arena.slab_count() < 2);
+}
+
+int check_arena() {
+	Arena arena( 4096 );
+	Arena other;
+	int errors = arena_blocks( arena );
+
+	arena.release();
+	errors += arena.used() != 0 || arena.slab_count() != 1;
+
+	// the kept slab is reused from its start
+	void *first = arena.allocate( 16 );
+
+	arena.release();
+	errors += arena.allocate( 16 ) != first;
+
+	// only the last block carved is given back at once
+	void *last = arena.allocate( 40 );
+
+	arena.deallocate( last, 40 );
+	errors += arena.allocate( 40 ) != last;
+
+	void *a = arena.allocate( 32 );
+	void *b = arena.allocate( 32 );
+
+	arena.deallocate( a, 32 );
+	errors += arena.allocate( 32 ) != static_cast<char *>( b ) + 32;
+
+	// a large block gets a slab of its own and the current slab goes on
+	int slabs = arena.slab_count();
+	void *small = arena.allocate( 16 );
+	void *large = arena.allocate( 8192 );
+
+	std::memset( large, 0, 8192 );
+	errors += arena.slab_count() != slabs + 1;
+	errors += arena.allocate( 16 ) != static_cast<char *>( small ) + 16;
+
+	arena.release();
+	errors += arena.used() != 0 || arena.slab_count() != 1;
+
+	errors += Arena_allocator<int>( arena ) != Arena_allocator<char>( arena );
+	errors += Arena_allocator<int>( arena ) == Arena_allocator<int>( other );
+
+	// tables that grow side by side interleave their arrays
+	for ( int round = 0; round < 3; ++round ) {
+		std::list< Arena_hash_table<int> > tables;
+		std::vector< std::set<int> > expected( 20 );
+
+		for ( int t = 0; t < 20; ++t ) {
+			tables.emplace_back( 1, Default_hash<int>(), arena );
+			tables.back().max_load_factor( 0.75 );
+			tables.back().max_erased_ratio( 0.25 );
+			errors += tables.back().get_allocator().source() != &arena;
+		}
+
+		std::srand( 16 + round );
+
+		for ( int i = 0; i < 20000; ++i ) {
+			int t = std::rand() % 20;
+			int key = std::rand() % 300;
+			std::list< Arena_hash_table<int> >::iterator table = tables.begin();
+
+			std::advance( table, t );
+
+			if ( std::rand() % 4 ) {
+				table->insert( key );
+				expected[t].insert( key );
+			} else {
+				errors += table->erase( key ) != (expected[t].erase( key ) > 0);
+			}
+		}
+
+		int t = 0;
+
+		for ( std::list< Arena_hash_table<int> >::iterator table = tables.begin(); table != tables.end(); ++table, ++t ) {
+			errors += table->size() != static_cast<int>( expected[t].size() );
+
+			for ( int key = 0; key < 300; ++key ) {
+				errors += table->member( key ) != (expected[t].count( key ) > 0);
+			}
+		}
+
+		tables.clear();
+		errors += arena.used() != 0;
+		arena.release();
+	}
+
+	return errors;
+}
+
+struct check_t {
+	char const *name;
+	int (*run)();
+};
+
+check_t const checks[] = {
+	{"probes", check_probes},
+	{"hashes", check_hashes},
+	{"map", check_map},
+	{"batch", check_batch},
+	{"build", check_build},
+	{"image", check_image},
+	{"iterators", check_iterators},
+	{"arena", check_arena}
+};
+
+int const n_checks = sizeof( checks )/sizeof( checks[0] );
+
+int main( int argc, char *argv[] ) {
+	for ( int j = 1; j < argc; ++j ) {
+		int i = 0;
+
+		while ( i < n_checks && std::strcmp( argv[j], checks[i].name ) ) {
+			++i;
+		}
+
+		if ( i == n_checks ) {
+			std::cerr << "Unknown check '" << argv[j] << "'; expecting one of";
+
+			for ( i = 0; i < n_checks; ++i ) {
+				std::cerr << " " << checks[i].name;
+			}
+
+			std::cerr << std::endl;
+
+			return -1;
+		}
+	}
+
+	int errors = 0;
+
+	for ( int i = 0; i < n_checks; ++i ) {
+		bool selected = (argc == 1);
+
+		for ( int j = 1; j < argc; ++j ) {
+			selected = selected || !std::strcmp( argv[j], checks[i].name );
+		}
+
+		if ( selected ) {
+			int found = checks[i].run();
+
+			std::cout << checks[i].name << ": " << found << " errors" << std::endl;
+			errors += found;
+		}
+	}
+
+	return (errors == 0) ? 0 : 1;
+}
@@ -0,0 +1,305 @@
+/*****************************************
+ * Quadratic_hash_table_image
+ *
+ * Keshav Kanatala
+ *
+ * A read-only view of a hash table saved with
+ * Quadratic_hash_table::save().  open() maps the file into memory and
+ * member() probes the mapped control bytes and entries directly, so
+ * reopening a table costs a validation pass over the file (and not
+ * even that if verification is skipped) instead of a rebuild.
+ *
+ * The image must have been saved by a table with the same Type,
+ * probe policy and hash function; the hash function is reconstructed
+ * from the saved seed.  Pages of the file are only read as probes touch them.
+ *****************************************/
+
+#ifndef QUADRATIC_HASH_TABLE_IMAGE_H
+#define QUADRATIC_HASH_TABLE_IMAGE_H
+
+#include "Quadratic_hash_table.h"
+#include "Table_image.h"
+
+#pragma push_macro("nullptr")
+#undef nullptr
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#pragma pop_macro("nullptr")
+
+template <typename Type, typename Probe = Quadratic_probe, typename Hash = Default_hash<Type> >
+class Quadratic_hash_table_image {
+private:
+    typedef Quadratic_hash_table<Type, Probe, Hash> table;
+
+    void *mapping;                          // the mapped file (nullptr if closed)
+    std::size_t mapping_size;               // size of the mapping
+    Table_image_header const *header;       // header of the image
+    unsigned char const *control;           // control bytes of the image
+    Type const *array;                      // entries of the image
+    Hash hasher;                            // hash function of the image
+
+public:
+    // constructors
+    Quadratic_hash_table_image();
+    ~Quadratic_hash_table_image();
+
+    // accessors
+    bool is_open() const;
+    int size() const;
+    int capacity() const;
+    double load_factor() const;
+    bool empty() const;
+    bool member(Type const &obj) const;
+
+    // mutators
+    bool open(char const *path, bool verify = true);
+    void close();
+
+private:
+    bool valid(bool verify) const;
+
+    // an image cannot be copied
+    Quadratic_hash_table_image(Quadratic_hash_table_image const &);
+    Quadratic_hash_table_image &operator=(Quadratic_hash_table_image const &);
+};
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Constructor and Destructor                                  * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Constructor: Quadratic_hash_table_image()
+ *
+ * Creates a closed image; call open() to map a file
+ */
+template <typename Type, typename Probe, typename Hash>
+Quadratic_hash_table_image<Type, Probe, Hash>::Quadratic_hash_table_image():
+mapping( nullptr ),
+mapping_size( 0 ),
+header( nullptr ),
+control( nullptr ),
+array( nullptr ),
+hasher() {
+    // empty constructor
+}
+
+/*
+ * Destructor
+ */
+template <typename Type, typename Probe, typename Hash>
+Quadratic_hash_table_image<Type, Probe, Hash>::~Quadratic_hash_table_image() {
+    close();
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Accessors                                                   * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: bool is_open()
+ *
+ * Returns: true if an image is mapped
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Quadratic_hash_table_image<Type, Probe, Hash>::is_open() const {
+    return mapping != nullptr;
+}
+
+/*
+ * Accessor: int size()
+ *
+ * Returns: the number of entries in the image (0 if closed)
+ */
+template <typename Type, typename Probe, typename Hash>
+int Quadratic_hash_table_image<Type, Probe, Hash>::size() const {
+    return is_open() ? header->count : 0;
+}
+
+/*
+ * Accessor: int capacity()
+ *
+ * Returns: the number of bins in the image (0 if closed)
+ */
+template <typename Type, typename Probe, typename Hash>
+int Quadratic_hash_table_image<Type, Probe, Hash>::capacity() const {
+    return is_open() ? 1 << header->power : 0;
+}
+
+/*
+ * Accessor: double load_factor()
+ *
+ * Returns: size() / capacity()
+ */
+template <typename Type, typename Probe, typename Hash>
+double Quadratic_hash_table_image<Type, Probe, Hash>::load_factor() const {
+    return is_open() ? static_cast<double>( size() ) / capacity() : 0.0;
+}
+
+/*
+ * Accessor: bool empty()
+ *
+ * Returns: true if size() is zero
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Quadratic_hash_table_image<Type, Probe, Hash>::empty() const {
+    return size() == 0;
+}
+
+/*
+ * Accessor: bool member(Type const &obj)
+ *           Probe the mapped bins as the saved table would have.
+ *
+ * Returns: true if the image contains obj
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Quadratic_hash_table_image<Type, Probe, Hash>::member(Type const &obj) const {
+    if ( !is_open() ) {
+        return false;
+    }
+
+    return table::locate( obj, hasher( obj ), array, control, capacity() ) != -1;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Mutators                                                    * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: bool open(char const *path, bool verify)
+ *         Map the image at path read-only, closing any image already
+ *         open.  The header is always checked against Type, the probe
+ *         policy, the hash function and the size of the file; if
+ *         verify is true, the checksum of the whole image is checked
+ *         as well.
+ *
+ * Returns: true if the image was mapped
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Quadratic_hash_table_image<Type, Probe, Hash>::open(char const *path, bool verify) {
+    close();
+
+    int fd = ::open( path, O_RDONLY );
+
+    if ( fd == -1 ) {
+        return false;
+    }
+
+    struct stat info;
+
+    if ( ::fstat( fd, &info ) != 0 || info.st_size < static_cast<off_t>( sizeof( Table_image_header ) ) ) {
+        ::close( fd );
+        return false;
+    }
+
+    void *ptr = ::mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+    // the mapping remains valid once the descriptor is closed
+    ::close( fd );
+
+    if ( ptr == MAP_FAILED ) {
+        return false;
+    }
+
+    mapping = ptr;
+    mapping_size = info.st_size;
+    header = static_cast<Table_image_header const *>( mapping );
+
+    if ( !valid( verify ) ) {
+        close();
+        return false;
+    }
+
+    control = static_cast<unsigned char const *>( mapping ) + header->control_offset;
+    array = reinterpret_cast<Type const *>( static_cast<char const *>( mapping ) + header->array_offset );
+    hasher = Hash( header->seed );
+
+    return true;
+}
+
+/*
+ * Method: void close()
+ *         Unmap the image, if one is open.
+ */
+template <typename Type, typename Probe, typename Hash>
+void Quadratic_hash_table_image<Type, Probe, Hash>::close() {
+    if ( mapping != nullptr ) {
+        ::munmap( mapping, mapping_size );
+    }
+
+    mapping = nullptr;
+    mapping_size = 0;
+    header = nullptr;
+    control = nullptr;
+    array = nullptr;
+}
+
+/*
+ * Accessor: bool valid(bool verify)
+ *
+ * Returns: true if the mapped header describes an image of this type
+ *          of table that fits exactly in the file, and, if verify is
+ *          true, the checksum matches the header and the contents
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Quadratic_hash_table_image<Type, Probe, Hash>::valid(bool verify) const {
+    Table_image_header const &h = *header;
+
+    if ( h.magic != TABLE_IMAGE_MAGIC || h.version != TABLE_IMAGE_VERSION
+         || h.endian != TABLE_IMAGE_ENDIAN || h.type_size != sizeof( Type )
+         || h.type_align != alignof( Type ) || h.probe_width != Probe::width
+         || h.probe_id != Probe::id || h.hash_id != Hash::id ) {
+        return false;
+    }
+
+    if ( h.power < 0 || h.power > 30 || h.count < 0 || h.count > (1 << h.power)
+         || h.erased < 0 || h.erased > (1 << h.power) - h.count ) {
+        return false;
+    }
+
+    unsigned long long size = 1ULL << h.power;
+    unsigned long long padded = (size < static_cast<unsigned long long>( Probe::width )) ? Probe::width : size;
+
+    // truncated files are caught here
+    if ( h.file_size != mapping_size || h.control_size != padded
+         || h.control_offset != image_align( sizeof( Table_image_header ) )
+         || h.array_offset != image_align( h.control_offset + h.control_size )
+         || h.array_offset + size * sizeof( Type ) != h.file_size ) {
+        return false;
+    }
+
+    if ( verify ) {
+        char const *base = static_cast<char const *>( mapping );
+        Table_image_header unsummed = h;
+
+        unsummed.checksum = 0;
+
+        unsigned long long checksum = image_checksum( &unsummed, sizeof( unsummed ), TABLE_IMAGE_FNV_BASIS );
+
+        checksum = image_checksum( base + h.control_offset, h.control_size, checksum );
+
+        checksum = image_checksum( base + h.array_offset, size * sizeof( Type ), checksum );
+
+        if ( checksum != h.checksum ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
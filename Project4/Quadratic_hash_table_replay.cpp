@@ -0,0 +1,69 @@
+/****************************************************
+ * Executable:   Quadratic_hash_table_replay
+ * Author:  Keshav Kanatala
+ *
+ * Replay a test script against Quadratic_hash_table:
+ *
+ *   Quadratic_hash_table_replay int|double SCRIPT [--mismatches]
+ *
+ * The script is written as for Quadratic_hash_table (for example,
+ * int.in.txt) and, without --mismatches, the output is the same as
+ *
+ *   Quadratic_hash_table int|double < SCRIPT
+ *
+ * only produced much faster, so scripts of millions of commands can
+ * be run.  SCRIPT may also be a binary trace written by
+ * Quadratic_hash_table_workload --binary.  With --mismatches, only
+ * the commands that did not succeed are printed, followed by a
+ * summary.
+ *
+ * The exit status is 1 if any command did not succeed, and -1 if the
+ * arguments are wrong or the script cannot be read.
+ ****************************************************/
+
+#include <iostream>
+#include <cstring>
+#include "Quadratic_hash_table_replay.h"
+
+int usage( char const *program ) {
+	std::cerr << "Usage: " << program << " int|double SCRIPT [--mismatches]" << std::endl;
+
+	return -1;
+}
+
+template <typename Type>
+int replay( char const *script, bool mismatches_only ) {
+	Quadratic_hash_table_replay<Type> replayer( mismatches_only );
+
+	if ( !mismatches_only ) {
+		std::cout << "Starting Test Run" << std::endl;
+	}
+
+	long long mismatches = replayer.replay( script );
+
+	if ( mismatches < 0 ) {
+		return -1;
+	}
+
+	if ( !mismatches_only ) {
+		std::cout << "Finishing Test Run" << std::endl;
+	}
+
+	return (mismatches == 0) ? 0 : 1;
+}
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 3 || argc > 4 || (argc == 4 && std::strcmp( argv[3], "--mismatches" )) ) {
+		return usage( argv[0] );
+	}
+
+	bool mismatches_only = (argc == 4);
+
+	if ( !std::strcmp( argv[1], "int" ) ) {
+		return replay<int>( argv[2], mismatches_only );
+	} else if ( !std::strcmp( argv[1], "double" ) ) {
+		return replay<double>( argv[2], mismatches_only );
+	}
+
+	return usage( argv[0] );
+}
@@ -0,0 +1,729 @@
+/*****************************************
+ * Quadratic_hash_table_replay
+ *
+ * Keshav Kanatala
+ *
+ * Replays a test script, such as int.in.txt, against a
+ * Quadratic_hash_table much faster than Quadratic_hash_table_tester
+ * reading std::cin.  The script is mapped into memory and its
+ * commands are split off in place, without copying or allocating,
+ * and each command is run by the tester itself (Tester::dispatch()
+ * and Quadratic_hash_table_tester::process()), with std::cin reading
+ * its arguments straight from the mapped script.  The commands, the
+ * messages and the numbering (including //, !! and !n) are therefore
+ * those of the tester.
+ *
+ * Output is written without flushing, in one of two modes:
+ *
+ *   full          every command's prompt and output, exactly as the
+ *                 tester prints them
+ *   mismatches    only the output of commands that did not succeed
+ *                 (and of summary, details, cout and stats), followed
+ *                 by a count of the commands, the mismatches and the
+ *                 rate at which they were replayed
+ *
+ * A trace written by Quadratic_hash_table_workload --binary (see
+ * Workload_trace.h) is recognized by its header and replayed in the
+ * same way: the arguments of each record are written out as the text
+ * they stand for, and the tester reads them from there.
+ *
+ * Unlike the tester, an exception escaping a command is reported as
+ * a mismatch instead of ending the run.
+ *****************************************/
+
+#ifndef QUADRATIC_HASH_TABLE_REPLAY_H
+#define QUADRATIC_HASH_TABLE_REPLAY_H
+
+#include "Quadratic_hash_table_tester.h"
+#include "Workload_trace.h"
+
+#pragma push_macro("nullptr")
+#undef nullptr
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#pragma pop_macro("nullptr")
+
+/*
+ * A read-only view of a whole file: mapped if it is a regular file,
+ * and read into memory from malloc() otherwise (a pipe, for example),
+ * so that the contents are not recorded by the allocation table.
+ */
+class Replay_file {
+private:
+    char const *contents;       // the bytes of the file
+    std::size_t length;         // the number of bytes
+    bool mapped;                // whether contents is a mapping
+
+public:
+    Replay_file():
+    contents( nullptr ),
+    length( 0 ),
+    mapped( false ) {
+        // empty constructor
+    }
+
+    ~Replay_file() {
+        close();
+    }
+
+    char const *begin() const {
+        return contents;
+    }
+
+    char const *end() const {
+        return contents + length;
+    }
+
+    bool open( char const *path );
+    void close();
+
+private:
+    // a file cannot be copied
+    Replay_file( Replay_file const & );
+    Replay_file &operator=( Replay_file const & );
+};
+
+/*
+ * Method: bool open(char const *path)
+ *
+ * Returns: true if the whole file is available
+ */
+inline bool Replay_file::open( char const *path ) {
+    close();
+
+    int fd = ::open( path, O_RDONLY );
+
+    if ( fd == -1 ) {
+        return false;
+    }
+
+    struct stat info;
+
+    if ( ::fstat( fd, &info ) == 0 && S_ISREG( info.st_mode ) ) {
+        length = info.st_size;
+
+        if ( length > 0 ) {
+            void *ptr = ::mmap( nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+            if ( ptr != MAP_FAILED ) {
+                ::madvise( ptr, length, MADV_SEQUENTIAL );
+                contents = static_cast<char const *>( ptr );
+                mapped = true;
+                ::close( fd );
+
+                return true;
+            }
+        }
+    }
+
+    // read what cannot be mapped
+    std::size_t capacity = 1 << 16;
+    char *buffer = static_cast<char *>( std::malloc( capacity ) );
+
+    length = 0;
+
+    while ( buffer != nullptr ) {
+        ssize_t n = ::read( fd, buffer + length, capacity - length );
+
+        if ( n <= 0 ) {
+            break;
+        }
+
+        length += n;
+
+        if ( length == capacity ) {
+            capacity *= 2;
+
+            char *larger = static_cast<char *>( std::realloc( buffer, capacity ) );
+
+            if ( larger == nullptr ) {
+                std::free( buffer );
+            }
+
+            buffer = larger;
+        }
+    }
+
+    ::close( fd );
+    contents = buffer;
+    mapped = false;
+
+    return buffer != nullptr;
+}
+
+/*
+ * Method: void close()
+ */
+inline void Replay_file::close() {
+    if ( mapped ) {
+        ::munmap( const_cast<char *>( contents ), length );
+    } else {
+        std::free( const_cast<char *>( contents ) );
+    }
+
+    contents = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+/*
+ * The output of one command.  Text is held in a fixed buffer until
+ * the command is finished, so that whether it printed only "Okay" can
+ * be checked; a command that prints more than the buffer holds has
+ * its output passed on as it is written.  Flushes (std::endl) are
+ * ignored until the command is finished.
+ */
+class Replay_output:public std::streambuf {
+private:
+    static const int SIZE = 1 << 14;
+
+    std::streambuf *target;     // where finished output goes
+    char buffer[SIZE];
+    char prefix[32];            // the prompt of the command
+    int prefix_length;
+    bool spilled;               // part of the output was passed on
+
+public:
+    explicit Replay_output( std::streambuf *t ):
+    target( t ),
+    prefix_length( 0 ),
+    spilled( false ) {
+        setp( buffer, buffer + SIZE );
+    }
+
+    // start the output of command n
+    void start( int n ) {
+        prefix_length = std::snprintf( prefix, sizeof( prefix ), "%d %% ", n );
+        spilled = false;
+        setp( buffer, buffer + SIZE );
+    }
+
+    // true if the command printed nothing or exactly "Okay" and a newline
+    bool okay() const {
+        return !spilled && (pptr() == pbase()
+                            || (pptr() - pbase() == 5 && std::memcmp( pbase(), "Okay\n", 5 ) == 0));
+    }
+
+    // pass the output on, preceded by the prompt
+    void finish( bool show ) {
+        if ( show ) {
+            if ( !spilled ) {
+                target->sputn( prefix, prefix_length );
+            }
+
+            target->sputn( pbase(), pptr() - pbase() );
+        }
+
+        setp( buffer, buffer + SIZE );
+    }
+
+protected:
+    int overflow( int c ) {
+        if ( !spilled ) {
+            target->sputn( prefix, prefix_length );
+            spilled = true;
+        }
+
+        target->sputn( pbase(), pptr() - pbase() );
+        setp( buffer, buffer + SIZE );
+
+        if ( c != traits_type::eof() ) {
+            *pptr() = static_cast<char>( c );
+            pbump( 1 );
+        }
+
+        return traits_type::not_eof( c );
+    }
+
+    int sync() {
+        return 0;
+    }
+};
+
+/*
+ * A key as text, preceded by a space, with enough digits to be read
+ * back exactly.
+ *
+ * Returns: the number of characters written, as snprintf()
+ */
+inline int replay_key_text( char *out, std::size_t size, int key ) {
+    return std::snprintf( out, size, " %d", key );
+}
+
+inline int replay_key_text( char *out, std::size_t size, double key ) {
+    return std::snprintf( out, size, " %.17g", key );
+}
+
+/*
+ * The arguments of a command, read by the tester from std::cin: a
+ * get area over the bytes of the script that follow the command, so
+ * that nothing is copied.  Reading stops at the end of the script.
+ */
+class Replay_input:public std::streambuf {
+public:
+    // read from [first, last)
+    void start( char const *first, char const *last ) {
+        setg( const_cast<char *>( first ), const_cast<char *>( first ), const_cast<char *>( last ) );
+    }
+
+    // the first byte not yet read
+    char const *position() const {
+        return gptr();
+    }
+};
+
+template <typename Type>
+class Quadratic_hash_table_replay:public Quadratic_hash_table_tester<Type> {
+    using Tester< Quadratic_hash_table<Type> >::object;
+    using Tester< Quadratic_hash_table<Type> >::command;
+
+private:
+    // a token is a view into the script
+    struct token {
+        char const *text;
+        int length;
+
+        bool is( char const *s ) const {
+            return static_cast<int>( std::strlen( s ) ) == length && std::memcmp( text, s, length ) == 0;
+        }
+    };
+
+    static const int HISTORY = 1000;
+
+    bool mismatches_only;
+    char const *cursor;         // next byte of the script
+    char const *end;            // end of the script
+    bool at_end;                // a read has reached the end of the script
+    bool binary;                // the script is a binary trace
+    int op;                     // opcode of the current record of a trace
+    char line[128];             // arguments of that record, as text
+    int line_length;
+    bool failed;                // an argument could not be read, or an exception escaped
+    Replay_input input;         // the arguments of the current command
+    token history[HISTORY];     // commands, as in ece250::history
+    int count;                  // number of the current command
+    long long commands;         // commands run
+    long long mismatches;       // commands that did not succeed
+
+public:
+    explicit Quadratic_hash_table_replay( bool m = false );
+    ~Quadratic_hash_table_replay();
+
+    long long replay( char const *path );
+    long long mismatch_count() const;
+
+private:
+    bool next( token &t );
+    void rest_of_line( token &t );
+    bool render();
+    template <typename Value>
+    bool take( Value &value );
+    bool execute( token const &name );
+    bool informational( token const &name ) const;
+
+    // a replay cannot be copied
+    Quadratic_hash_table_replay( Quadratic_hash_table_replay const & );
+    Quadratic_hash_table_replay &operator=( Quadratic_hash_table_replay const & );
+};
+
+/*
+ * Constructor: Quadratic_hash_table_replay(bool m)
+ *
+ * Creates a replay that prints only mismatches and a summary if m is
+ * true, and every command otherwise
+ */
+template <typename Type>
+Quadratic_hash_table_replay<Type>::Quadratic_hash_table_replay( bool m ):
+mismatches_only( m ),
+cursor( nullptr ),
+end( nullptr ),
+at_end( false ),
+binary( false ),
+op( WORKLOAD_END ),
+line_length( 0 ),
+failed( false ),
+count( 0 ),
+commands( 0 ),
+mismatches( 0 ) {
+    for ( int i = 0; i < HISTORY; ++i ) {
+        history[i].text = "";
+        history[i].length = 0;
+    }
+}
+
+/*
+ * Destructor
+ */
+template <typename Type>
+Quadratic_hash_table_replay<Type>::~Quadratic_hash_table_replay() {
+    delete object;
+}
+
+/*
+ * Accessor: long long mismatch_count()
+ *
+ * Returns: the number of commands that did not succeed so far
+ */
+template <typename Type>
+long long Quadratic_hash_table_replay<Type>::mismatch_count() const {
+    return mismatches;
+}
+
+/*
+ * Method: long long replay(char const *path)
+ *         Run the script at path, as Tester::run() would run it from
+ *         std::cin.
+ *
+ * Returns: the number of mismatches, or -1 if the script cannot be read
+ */
+template <typename Type>
+long long Quadratic_hash_table_replay<Type>::replay( char const *path ) {
+    Replay_file file;
+
+    if ( !file.open( path ) ) {
+        std::cerr << "Cannot read " << path << std::endl;
+
+        return -1;
+    }
+
+    cursor = file.begin();
+    end = file.end();
+    binary = false;
+
+    Workload_trace_header header;
+
+    if ( end - cursor >= static_cast<long>( sizeof( header ) ) ) {
+        std::memcpy( &header, cursor, sizeof( header ) );
+
+        if ( header.magic == WORKLOAD_TRACE_MAGIC ) {
+            if ( header.version != WORKLOAD_TRACE_VERSION || header.key_size != sizeof( Type ) ) {
+                std::cerr << path << " is not a trace of this version and type" << std::endl;
+
+                return -1;
+            }
+
+            binary = true;
+            cursor += sizeof( header );
+        }
+    }
+
+    at_end = (cursor == end);
+
+    std::streambuf *original = std::cout.rdbuf();
+    std::streambuf *original_input = std::cin.rdbuf( &input );
+    std::ostream *original_tie = std::cin.tie( nullptr );
+    Replay_output output( original );
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    ece250::allocation_table.stop_recording();
+
+    // every command writes to std::cout, which is held per command
+    std::cout.rdbuf( &output );
+
+    while ( !at_end ) {
+        ++ece250::count;
+        count = ece250::count;
+        output.start( count );
+
+        token name;
+
+        if ( !next( name ) ) {
+            std::cout << "Exiting...\n";
+            output.finish( !mismatches_only );
+            break;
+        }
+
+        // comments are printed whole
+        if ( name.length >= 2 && name.text[0] == '/' && name.text[1] == '/' ) {
+            rest_of_line( name );
+            std::cout.write( name.text, name.length ) << '\n';
+            output.finish( !mismatches_only );
+            continue;
+        }
+
+        if ( at_end ) {
+            std::cout << "Exiting...\n";
+            output.finish( !mismatches_only );
+            break;
+        }
+
+        if ( name.is( "!!" ) ) {
+            if ( count == 1 ) {
+                std::cout << "Event not found\n";
+                output.finish( !mismatches_only );
+                continue;
+            }
+
+            name = history[count - 1];
+        } else if ( name.text[0] == '!' ) {
+            int n = 0;
+
+            // the leading digits, as the tester reads them
+            for ( int i = 1; i < name.length && i < 10 && std::isdigit( static_cast<unsigned char>( name.text[i] ) ); ++i ) {
+                n = 10 * n + (name.text[i] - '0');
+            }
+
+            if ( n <= 0 || n >= count || n >= HISTORY ) {
+                std::cout << "Event not found\n";
+                output.finish( !mismatches_only );
+                continue;
+            }
+
+            name = history[n];
+        }
+
+        if ( count < HISTORY ) {
+            history[count] = name;
+        }
+
+        if ( !execute( name ) ) {
+            output.finish( !mismatches_only );
+            break;
+        }
+
+        ++commands;
+
+        bool mismatch = failed || (!output.okay() && !informational( name ));
+
+        if ( mismatch ) {
+            ++mismatches;
+        }
+
+        output.finish( !mismatches_only || mismatch || informational( name ) );
+    }
+
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    std::cout.rdbuf( original );
+    std::cin.rdbuf( original_input );
+    std::cin.tie( original_tie );
+    std::cin.clear();
+
+    if ( mismatches_only ) {
+        std::cout << "Replayed " << commands << " commands with " << mismatches << " mismatches in "
+                  << seconds << " s (" << (seconds > 0 ? commands / seconds : 0.0) << " commands/s)\n";
+    }
+
+    std::cout.flush();
+
+    return mismatches;
+}
+
+/*
+ * Method: bool execute(token const &name)
+ *         Run one command through the tester, Tester::dispatch() and
+ *         Quadratic_hash_table_tester::process(), which read its
+ *         arguments from the script through std::cin (or, for a
+ *         trace, from their text).  The command fails if an argument
+ *         cannot be read or an exception escapes.
+ *
+ * Returns: false if the command is 'exit'
+ */
+template <typename Type>
+bool Quadratic_hash_table_replay<Type>::execute( token const &name ) {
+    bool more = true;
+
+    command.assign( name.text, name.length );
+    std::cin.clear();
+
+    if ( !binary ) {
+        input.start( cursor, end );
+    } else if ( render() ) {
+        input.start( line, line + line_length );
+    } else {
+        std::cout << "Failure: the trace ends within the command\n";
+        failed = true;
+
+        return true;
+    }
+
+    try {
+        more = this->dispatch();
+    } catch ( ... ) {
+        ece250::allocation_table.stop_recording();
+        std::cout << "Failure: an exception escaped the command\n";
+        std::cin.setstate( std::ios::failbit );
+    }
+
+    failed = std::cin.fail();
+
+    if ( !binary ) {
+        cursor = input.position();
+        at_end = (cursor == end);
+    }
+
+    return more;
+}
+
+/*
+ * Accessor: bool informational(token const &name)
+ *
+ * Returns: true if the command prints a report rather than "Okay"
+ */
+template <typename Type>
+bool Quadratic_hash_table_replay<Type>::informational( token const &name ) const {
+    return name.is( "summary" ) || name.is( "details" ) || name.is( "cout" ) || name.is( "stats" );
+}
+
+/*
+ * Method: bool next(token &t)
+ *         Read the next whitespace-separated token, as operator>>
+ *         reads a string.
+ *
+ * Returns: false if the script has no more tokens
+ */
+template <typename Type>
+bool Quadratic_hash_table_replay<Type>::next( token &t ) {
+    if ( binary ) {
+        op = (cursor == end) ? static_cast<int>( WORKLOAD_END ) : static_cast<unsigned char>( *cursor );
+
+        // the end of a trace is where the end of a text file would be
+        if ( op == WORKLOAD_END || op >= WORKLOAD_OPS ) {
+            t.text = "";
+            t.length = 0;
+            cursor = end;
+            at_end = true;
+
+            return false;
+        }
+
+        t.text = workload_op_names[op];
+        t.length = static_cast<int>( std::strlen( t.text ) );
+        ++cursor;
+
+        return true;
+    }
+
+    while ( cursor != end && std::isspace( static_cast<unsigned char>( *cursor ) ) ) {
+        ++cursor;
+    }
+
+    t.text = cursor;
+
+    while ( cursor != end && !std::isspace( static_cast<unsigned char>( *cursor ) ) ) {
+        ++cursor;
+    }
+
+    t.length = static_cast<int>( cursor - t.text );
+    at_end = (cursor == end);
+
+    return t.length > 0;
+}
+
+/*
+ * Method: void rest_of_line(token &t)
+ *         Extend t to the end of its line and move past the line.
+ */
+template <typename Type>
+void Quadratic_hash_table_replay<Type>::rest_of_line( token &t ) {
+    while ( cursor != end && *cursor != '\n' ) {
+        ++cursor;
+    }
+
+    t.length = static_cast<int>( cursor - t.text );
+
+    if ( cursor != end ) {
+        ++cursor;
+    } else {
+        at_end = true;
+    }
+}
+
+/*
+ * Method: bool render()
+ *         Write the arguments of the current record of a trace into
+ *         line, as the text they stand for, and move past them.
+ *
+ * Returns: false if the trace ends first
+ */
+template <typename Type>
+bool Quadratic_hash_table_replay<Type>::render() {
+    int const size = sizeof( line );
+
+    line_length = 0;
+
+    for ( char const *argument = workload_op_arguments[op]; *argument != '\0'; ++argument ) {
+        int n;
+        unsigned char byte;
+        double x;
+        Type key;
+        int written = 0;
+
+        switch ( *argument ) {
+            case 'i':
+                if ( !take( n ) ) {
+                    return false;
+                }
+
+                written = std::snprintf( line + line_length, size - line_length, " %d", n );
+                break;
+            case 'b':
+                if ( !take( byte ) ) {
+                    return false;
+                }
+
+                written = std::snprintf( line + line_length, size - line_length, " %d", byte );
+                break;
+            case 'd':
+                if ( !take( x ) ) {
+                    return false;
+                }
+
+                written = std::snprintf( line + line_length, size - line_length, " %.17g", x );
+                break;
+            case 'k':
+                if ( !take( key ) ) {
+                    return false;
+                }
+
+                written = replay_key_text( line + line_length, size - line_length, key );
+                break;
+            default:
+                // an opcode standing for a word
+                if ( !take( byte ) ) {
+                    return false;
+                }
+
+                written = std::snprintf( line + line_length, size - line_length, " %s",
+                                         (byte < WORKLOAD_OPS) ? workload_op_names[byte] : "?" );
+                break;
+        }
+
+        line_length += written;
+    }
+
+    return true;
+}
+
+/*
+ * Method: bool take(Value &value)
+ *         Copy the next argument of a binary trace into value.
+ *
+ * Returns: false if the trace ends first
+ */
+template <typename Type>
+template <typename Value>
+bool Quadratic_hash_table_replay<Type>::take( Value &value ) {
+    if ( end - cursor < static_cast<long>( sizeof( Value ) ) ) {
+        cursor = end;
+        at_end = true;
+
+        return false;
+    }
+
+    std::memcpy( &value, cursor, sizeof( Value ) );
+    cursor += sizeof( Value );
+
+    return true;
+}
+
+#endif
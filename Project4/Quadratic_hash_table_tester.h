@@ -24,8 +24,9 @@
 
 template <typename Type>
 class Quadratic_hash_table_tester:public Tester< Quadratic_hash_table<Type> > {
-	using Tester< Quadratic_hash_table<Type> >::object;
-	using Tester< Quadratic_hash_table<Type> >::command;
+	protected:
+		using Tester< Quadratic_hash_table<Type> >::object;
+		using Tester< Quadratic_hash_table<Type> >::command;
 
 	public:
 		Quadratic_hash_table_tester( Quadratic_hash_table<Type> *obj =
@@ -55,6 +56,8 @@ class Quadratic_hash_table_tester:public Tester< Quadratic_hash_table<Type> > {
  *   empty b         empty           the result is the Boolean value b (0/1)
  *   member n b      member          checks if n is in the hash table (return value b)
  *   bin n m         bin             checks if m is in bin n
+ *   resizing b      resizing        checks if a migration is in progress (b is 0/1)
+ *   compactions n   compactions     checks that the table was compacted n times
  *
  *  Mutators
  *
@@ -62,10 +65,13 @@ class Quadratic_hash_table_tester:public Tester< Quadratic_hash_table<Type> > {
  *   insert!         insert          an overflow exception is expected
  *   erase n b       erase           the element can be inserted into the hash table
  *   clear           clear           empties the hash table
+ *   max_load_factor: d              sets the load factor that triggers a resize
+ *   max_erased_ratio: d             sets the ratio of erased bins that triggers a compaction
  *
  *  Others
  *
  *   cout            cout << hash    print the hash table
+ *   stats           stats           print the probe, cluster and collision statistics
  *   summary                         prints the amount of memory allocated
  *                                   minus the memory deallocated
  *   details                         prints a detailed description of which
@@ -175,6 +181,34 @@ void Quadratic_hash_table_tester<Type>::process() {
 		} else {
 			std::cout << ": Failure in bin(" << n << "): expecting the value '" << expected_value << "' but got '" << actual_value << "'" << std::endl;
 		}
+	} else if ( command == "resizing" ) {
+		// check if a migration is in progress
+
+		bool expected_resizing;
+
+		std::cin >> expected_resizing;
+
+		bool actual_resizing = object->resizing();
+
+		if ( actual_resizing == expected_resizing ) {
+			std::cout << "Okay" << std::endl;
+		} else {
+			std::cout << ": Failure in resizing(): expecting the value '" << expected_resizing << "' but got '" << actual_resizing << "'" << std::endl;
+		}
+	} else if ( command == "compactions" ) {
+		// check if the number of compactions equals the next integer read
+
+		int expected_compactions;
+
+		std::cin >> expected_compactions;
+
+		int actual_compactions = object->compactions();
+
+		if ( actual_compactions == expected_compactions ) {
+			std::cout << "Okay" << std::endl;
+		} else {
+			std::cout << ": Failure in compactions(): expecting the value '" << expected_compactions << "' but got '" << actual_compactions << "'" << std::endl;
+		}
 	} else if ( command == "insert" ) {
 		// insert the next integer read onto the hash table
 
@@ -218,9 +252,27 @@ void Quadratic_hash_table_tester<Type>::process() {
 	} else if ( command == "clear" ) {
 		object->clear();
 
+		std::cout << "Okay" << std::endl;
+	} else if ( command == "max_load_factor:" ) {
+		double load;
+
+		std::cin >> load;
+
+		object->max_load_factor( load );
+		std::cout << "Okay" << std::endl;
+	} else if ( command == "max_erased_ratio:" ) {
+		double ratio;
+
+		std::cin >> ratio;
+
+		object->max_erased_ratio( ratio );
 		std::cout << "Okay" << std::endl;
 	} else if ( command == "cout" ) {
 		std::cout << *object << std::endl;
+	} else if ( command == "stats" ) {
+		// print the statistics, one "name value" pair per line
+
+		std::cout << "Okay" << std::endl << object->stats();
 	} else {
 		std::cout << command << ": Command not found." << std::endl;
 	}
@@ -0,0 +1,580 @@
+/****************************************************
+ * Executable:   Quadratic_hash_table_workload
+ * Author:  Keshav Kanatala
+ *
+ * Generate a test script for Quadratic_hash_table from a model of a
+ * workload:
+ *
+ *   Quadratic_hash_table_workload MODEL [--type int|double] [--power P]
+ *                                       [--ops N] [--load L] [--skew S]
+ *                                       [--seed S] [--binary]
+ *                                       [--output FILE]
+ *
+ * The script creates a table of 2^P bins (by default 2^16) with new:,
+ * runs N (by default 1000000) insert, member and erase commands on it,
+ * checking size every 1024 commands, and deletes it.  Every command
+ * expects the answer the table must give, and an insert into a full
+ * table is written as insert!, so a correct table replays the script
+ * without a mismatch:
+ *
+ *   Quadratic_hash_table_workload zipf --output zipf.txt
+ *   Quadratic_hash_table_replay int zipf.txt --mismatches
+ *
+ * The models are
+ *
+ *   uniform      30% insert, 50% member and 20% erase of keys drawn
+ *                uniformly from a range sized so that the table
+ *                settles at a load factor of about L (by default 0.5)
+ *   zipf         the same mix, with key k of the range drawn with
+ *                probability proportional to 1/k^S (by default S is
+ *                1), so a few hot keys take most of the commands
+ *   sequential   insert the ids 0, 1, 2, ... in order, erasing the
+ *                oldest once L of the bins are full, and look up an id
+ *                in the window and one that was erased
+ *   churn        fill L of the bins with random keys, then repeatedly
+ *                erase a present key, insert a new one and look up a
+ *                present key and an absent one
+ *   adversarial  churn, with every key in the same home bin modulo
+ *                capacity() under the default hash function; every
+ *                probe then walks one cluster, so keep P small.  Only
+ *                2^(32 - P) ints share a home bin, so for --type int
+ *                the model needs 1.25 L 2^P of them at most that
+ *
+ * Keys are scattered over the ints (or, for --type double, are those
+ * ints plus 0.5), and the same MODEL, options and seed (by default 1)
+ * give the same script.  The keys of the adversarial model are built
+ * to collide instead: multiples of capacity() for --type int and, for
+ * --type double, doubles of moderate magnitude found by inverting the
+ * mix of Float_hash.
+ *
+ * The script is written as text, in the format of int.in.txt, or with
+ * --binary as a trace (see Workload_trace.h) that
+ * Quadratic_hash_table_replay reads with the same results.  It is
+ * written to the standard output unless FILE is given.
+ ****************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Quadratic_hash_table.h"
+#include "Workload_trace.h"
+
+typedef std::mt19937_64 random_t;
+
+template <typename Type>
+Type make_key( int i );
+
+template <>
+int make_key<int>( int i ) {
+	return i;
+}
+
+template <>
+double make_key<double>( int i ) {
+	return i + 0.5;
+}
+
+/*
+ * A script being written.  It follows the contents of the table so
+ * that every command can be given its expected answer.
+ */
+template <typename Type>
+class Script {
+	private:
+		std::ostream &out;
+		bool binary;
+		int capacity;
+		std::vector<Type> keys;                 // the keys in the table
+		std::unordered_map<Type, int> index;    // position of each key in keys
+		long long commands;                     // insert, member and erase commands
+
+	public:
+		Script( std::ostream &o, bool b, int power ):
+		out( o ),
+		binary( b ),
+		capacity( 1 << power ),
+		commands( 0 ) {
+			if ( binary ) {
+				Workload_trace_header header;
+
+				std::memset( &header, 0, sizeof( header ) );
+				header.magic = WORKLOAD_TRACE_MAGIC;
+				header.version = WORKLOAD_TRACE_VERSION;
+				header.key_size = sizeof( Type );
+				out.write( reinterpret_cast<char const *>( &header ), sizeof( header ) );
+			} else {
+				// enough digits that every double reads back exactly
+				out.precision( 17 );
+			}
+
+			command( WORKLOAD_NEW_POWER );
+			argument( power );
+			end_command();
+		}
+
+		int size() const {
+			return static_cast<int>( keys.size() );
+		}
+
+		long long count() const {
+			return commands;
+		}
+
+		bool contains( Type const &key ) const {
+			return index.find( key ) != index.end();
+		}
+
+		// a key in the table, chosen at random
+		Type present( random_t &random ) const {
+			return keys[std::uniform_int_distribution<int>( 0, size() - 1 )( random )];
+		}
+
+		void insert( Type const &key ) {
+			if ( size() == capacity ) {
+				// a full table throws even for a key it holds
+				command( WORKLOAD_INSERT_OVERFLOW );
+				argument( key );
+			} else {
+				command( WORKLOAD_INSERT );
+				argument( key );
+
+				if ( !contains( key ) ) {
+					index[key] = size();
+					keys.push_back( key );
+				}
+			}
+
+			end_command();
+			counted();
+		}
+
+		void member( Type const &key ) {
+			command( WORKLOAD_MEMBER );
+			argument( key );
+			argument( contains( key ) );
+			end_command();
+			counted();
+		}
+
+		void erase( Type const &key ) {
+			typename std::unordered_map<Type, int>::iterator found = index.find( key );
+
+			command( WORKLOAD_ERASE );
+			argument( key );
+			argument( found != index.end() );
+			end_command();
+
+			if ( found != index.end() ) {
+				int i = found->second;
+
+				index.erase( found );
+
+				if ( i != size() - 1 ) {
+					keys[i] = keys.back();
+					index[keys[i]] = i;
+				}
+
+				keys.pop_back();
+			}
+
+			counted();
+		}
+
+		// check the size, delete the table and end the script
+		void finish() {
+			check();
+			command( WORKLOAD_DELETE );
+			end_command();
+
+			if ( binary ) {
+				command( WORKLOAD_END );
+			}
+
+			out.flush();
+		}
+
+	private:
+		void check() {
+			command( WORKLOAD_SIZE );
+			argument( size() );
+			end_command();
+		}
+
+		void counted() {
+			if ( ++commands % 1024 == 0 ) {
+				check();
+			}
+		}
+
+		void command( Workload_op op ) {
+			if ( binary ) {
+				out.put( static_cast<char>( op ) );
+			} else {
+				out << workload_op_names[op];
+			}
+		}
+
+		void argument( int n ) {
+			if ( binary ) {
+				out.write( reinterpret_cast<char const *>( &n ), sizeof( n ) );
+			} else {
+				out << ' ' << n;
+			}
+		}
+
+		void argument( double x ) {
+			if ( binary ) {
+				out.write( reinterpret_cast<char const *>( &x ), sizeof( x ) );
+			} else {
+				out << ' ' << x;
+			}
+		}
+
+		void argument( bool b ) {
+			if ( binary ) {
+				out.put( b ? 1 : 0 );
+			} else {
+				out << ' ' << (b ? 1 : 0);
+			}
+		}
+
+		void end_command() {
+			if ( !binary ) {
+				out << '\n';
+			}
+		}
+};
+
+struct Options {
+	int power;
+	long long ops;
+	double load;
+	double skew;
+};
+
+/*
+ * The uniform and zipf models: a mix of commands on a fixed range of
+ * keys.  A key is present with probability 0.6 once inserts (30%)
+ * balance erases (20%), so the range has load / 0.6 keys per bin.
+ */
+template <typename Type>
+void mixed( Script<Type> &script, random_t &random, Options const &options, bool zipf ) {
+	int range = std::max( 1, static_cast<int>( options.load / 0.6 * (1 << options.power) ) );
+	std::vector<double> cumulative;
+
+	if ( zipf ) {
+		double total = 0.0;
+
+		cumulative.resize( range );
+
+		for ( int k = 0; k < range; ++k ) {
+			total += 1.0 / std::pow( k + 1.0, options.skew );
+			cumulative[k] = total;
+		}
+	}
+
+	std::uniform_real_distribution<double> unit( 0.0, 1.0 );
+	std::uniform_int_distribution<int> uniform( 0, range - 1 );
+
+	while ( script.count() < options.ops ) {
+		int k;
+
+		if ( zipf ) {
+			double u = unit( random ) * cumulative.back();
+
+			k = static_cast<int>( std::upper_bound( cumulative.begin(), cumulative.end(), u ) - cumulative.begin() );
+			k = std::min( k, range - 1 );
+		} else {
+			k = uniform( random );
+		}
+
+		Type key = make_key<Type>( scattered_key( k ) );
+		double u = unit( random );
+
+		if ( u < 0.3 ) {
+			script.insert( key );
+		} else if ( u < 0.8 ) {
+			script.member( key );
+		} else {
+			script.erase( key );
+		}
+	}
+}
+
+/*
+ * The sequential model: a sliding window of consecutive ids.
+ */
+template <typename Type>
+void sequential( Script<Type> &script, random_t &random, Options const &options ) {
+	int window = std::max( 1, static_cast<int>( options.load * (1 << options.power) ) );
+	int oldest = 0;
+	int next = 0;
+
+	while ( script.count() < options.ops ) {
+		script.insert( make_key<Type>( next++ ) );
+
+		if ( next - oldest > window ) {
+			script.erase( make_key<Type>( oldest++ ) );
+		}
+
+		script.member( make_key<Type>( std::uniform_int_distribution<int>( oldest, next - 1 )( random ) ) );
+
+		if ( oldest > 0 ) {
+			script.member( make_key<Type>( std::uniform_int_distribution<int>( 0, oldest - 1 )( random ) ) );
+		}
+	}
+}
+
+/*
+ * The churn and adversarial models: fill to the target load from a
+ * source of keys, then replace keys at that load.  next_key() returns
+ * a key that is not in the table.
+ */
+template <typename Type, typename Source>
+void churn( Script<Type> &script, random_t &random, Options const &options, Source next_key ) {
+	int target = std::max( 1, static_cast<int>( options.load * (1 << options.power) ) );
+
+	while ( script.size() < target && script.count() < options.ops ) {
+		script.insert( next_key() );
+	}
+
+	while ( script.count() < options.ops ) {
+		script.erase( script.present( random ) );
+		script.insert( next_key() );
+		script.member( script.present( random ) );
+		script.member( next_key() );
+	}
+}
+
+template <typename Type>
+void random_churn( Script<Type> &script, random_t &random, Options const &options ) {
+	churn( script, random, options, [&]() {
+		Type key;
+
+		do {
+			key = make_key<Type>( static_cast<int>( random() ) );
+		} while ( script.contains( key ) );
+
+		return key;
+	} );
+}
+
+/*
+ * Keys for the adversarial model: the target number of entries and a
+ * quarter as many again, all with the home bin of make_key<Type>( 0 )
+ * under Default_hash<Type>.  The keys are built rather than searched
+ * for, so the model costs no more to generate than churn.
+ *
+ * Returns: false if there are not that many such keys
+ */
+template <typename Type>
+bool colliding_keys( Options const &options, std::vector<Type> &pool );
+
+std::size_t wanted_keys( Options const &options ) {
+	int target = std::max( 1, static_cast<int>( options.load * (1 << options.power) ) );
+
+	return target + std::max( 1, target / 4 );
+}
+
+/*
+ * The int keys whose low P bits are zero (those of key 0) are the
+ * 2^(32 - P) multiples of capacity(); the multiplier j runs through
+ * them in a scattered order.
+ */
+template <>
+bool colliding_keys<int>( Options const &options, std::vector<int> &pool ) {
+	std::size_t wanted = wanted_keys( options );
+	unsigned int multiples = 1u << (32 - options.power);
+
+	if ( wanted > multiples ) {
+		return false;
+	}
+
+	for ( unsigned int j = 0; pool.size() < wanted; ++j ) {
+		pool.push_back( static_cast<int>( (static_cast<unsigned int>( scattered_key( j ) ) & (multiples - 1)) << options.power ) );
+	}
+
+	return true;
+}
+
+/*
+ * The inverse of murmur_mix(): undo each multiplication with the
+ * inverse of its odd constant modulo 2^64 and each x ^= x >> 33 by
+ * repeating it.
+ */
+unsigned long long murmur_unmix( unsigned long long x ) {
+	x ^= x >> 33;
+	x *= 0x9CB4B2F8129337DBULL;
+	x ^= x >> 33;
+	x *= 0x4F74430C22A54005ULL;
+	x ^= x >> 33;
+
+	return x;
+}
+
+/*
+ * Float_hash mixes the bit pattern of a double, so a double with a
+ * given home bin is found by unmixing a hash code with that bin in its
+ * low P bits, and distinct codes give distinct keys.  Codes whose key
+ * is not a double of moderate magnitude (a NaN, an infinity, a zero, a
+ * subnormal, or a value a script cannot write compactly) are skipped,
+ * about 15 of every 16.
+ */
+template <>
+bool colliding_keys<double>( Options const &options, std::vector<double> &pool ) {
+	std::size_t wanted = wanted_keys( options );
+	Default_hash<double> hash;
+	unsigned long long home = hash( make_key<double>( 0 ) ) & ((1ULL << options.power) - 1);
+
+	for ( unsigned long long j = 0; pool.size() < wanted && j < (1ULL << 40); ++j ) {
+		unsigned long long bits = murmur_unmix( ((j * 0x9E3779B97F4A7C15ULL) << options.power) | home ) ^ hash.seed();
+		int exponent = static_cast<int>( (bits >> 52) & 0x7FF );
+
+		if ( exponent >= 1023 - 64 && exponent <= 1023 + 64 ) {
+			double key;
+
+			std::memcpy( &key, &bits, sizeof( key ) );
+			pool.push_back( key );
+		}
+	}
+
+	return pool.size() == wanted;
+}
+
+template <typename Type>
+void adversarial( Script<Type> &script, random_t &random, Options const &options,
+                  std::vector<Type> const &pool ) {
+	std::uniform_int_distribution<int> pick( 0, static_cast<int>( pool.size() ) - 1 );
+
+	churn( script, random, options, [&]() {
+		Type key;
+
+		do {
+			key = pool[pick( random )];
+		} while ( script.contains( key ) );
+
+		return key;
+	} );
+}
+
+/*
+ * Write the script of the model to FILE, or to the standard output if
+ * output is empty.  Nothing is written if the adversarial model cannot
+ * find its keys.
+ */
+template <typename Type>
+int generate( std::string const &model, std::string const &output, bool binary,
+              unsigned long long seed, Options const &options ) {
+	std::vector<Type> pool;
+
+	if ( model == "adversarial" && !colliding_keys( options, pool ) ) {
+		std::cerr << "Cannot find enough colliding keys; try a smaller --power or --load" << std::endl;
+
+		return 1;
+	}
+
+	std::ofstream file;
+
+	if ( !output.empty() ) {
+		file.open( output.c_str(), std::ios::out | std::ios::binary );
+
+		if ( !file ) {
+			std::cerr << "Cannot write " << output << std::endl;
+
+			return -1;
+		}
+	}
+
+	std::ostream &out = output.empty() ? std::cout : file;
+	random_t random( seed );
+	Script<Type> script( out, binary, options.power );
+
+	if ( model == "uniform" || model == "zipf" ) {
+		mixed( script, random, options, model == "zipf" );
+	} else if ( model == "sequential" ) {
+		sequential( script, random, options );
+	} else if ( model == "churn" ) {
+		random_churn( script, random, options );
+	} else {
+		adversarial( script, random, options, pool );
+	}
+
+	script.finish();
+
+	return out ? 0 : 1;
+}
+
+int usage( char const *program ) {
+	std::cerr << "Usage: " << program << " uniform|zipf|sequential|churn|adversarial"
+	          << " [--type int|double] [--power P] [--ops N] [--load L] [--skew S]"
+	          << " [--seed S] [--binary] [--output FILE]" << std::endl;
+
+	return -1;
+}
+
+int main( int argc, char *argv[] ) {
+	if ( argc < 2 ) {
+		return usage( argv[0] );
+	}
+
+	std::string model = argv[1];
+	std::string type = "int";
+	std::string output;
+	unsigned long long seed = 1;
+	bool binary = false;
+	Options options;
+
+	options.power = 16;
+	options.ops = 1000000;
+	options.load = 0.5;
+	options.skew = 1.0;
+
+	if ( model != "uniform" && model != "zipf" && model != "sequential"
+	     && model != "churn" && model != "adversarial" ) {
+		return usage( argv[0] );
+	}
+
+	for ( int i = 2; i < argc; ++i ) {
+		std::string option = argv[i];
+
+		if ( option == "--binary" ) {
+			binary = true;
+		} else if ( i + 1 == argc ) {
+			return usage( argv[0] );
+		} else if ( option == "--type" ) {
+			type = argv[++i];
+		} else if ( option == "--power" ) {
+			options.power = std::atoi( argv[++i] );
+		} else if ( option == "--ops" ) {
+			options.ops = std::atoll( argv[++i] );
+		} else if ( option == "--load" ) {
+			options.load = std::atof( argv[++i] );
+		} else if ( option == "--skew" ) {
+			options.skew = std::atof( argv[++i] );
+		} else if ( option == "--seed" ) {
+			seed = std::strtoull( argv[++i], 0, 10 );
+		} else if ( option == "--output" ) {
+			output = argv[++i];
+		} else {
+			return usage( argv[0] );
+		}
+	}
+
+	if ( (type != "int" && type != "double") || options.power < 1 || options.power > 26
+	     || options.ops < 0 || options.load <= 0.0 || options.load > 1.0 || options.skew < 0.0 ) {
+		return usage( argv[0] );
+	}
+
+	if ( type == "int" ) {
+		return generate<int>( model, output, binary, seed, options );
+	} else {
+		return generate<double>( model, output, binary, seed, options );
+	}
+}
@@ -0,0 +1,708 @@
+/*****************************************
+ * Read_mostly_hash_table
+ *
+ * Keshav Kanatala
+ *
+ * An open-addressing hash table for workloads dominated by member()
+ * calls from many threads, with occasional insert() and erase().
+ *
+ * Readers take no lock and write nothing that another reader reads:
+ *
+ *  - every bin carries a version that the writer makes odd while it
+ *    changes the bin and even again afterwards (a per-bin seqlock);
+ *    a reader that sees the version change while it reads a bin reads
+ *    the bin again, so it never acts on a half-written entry
+ *
+ *  - resizing or compacting never happens in place: the writer builds
+ *    a new set of bins on the side and publishes it with one atomic
+ *    store, so a reader keeps probing the bins it started with while
+ *    the writer rehashes
+ *
+ *  - the bins that were replaced are freed only once no reader can
+ *    still be using them (epoch-based reclamation).  Each reader owns
+ *    a slot, on a cache line of its own, in which it announces the
+ *    epoch it started in; this is the only store a reader makes.
+ *
+ * A thread reads through a Read_mostly_hash_table::reader, which
+ * claims one of the max_readers (64) slots for its lifetime; while
+ * every slot is in use, constructing another reader throws overflow.
+ *
+ * Writers are serialized by a mutex that readers never touch, so any
+ * thread may insert, erase or clear.  Type must be trivially copyable
+ * and of 1, 2, 4 or 8 bytes: entries are copied in and out of atomics,
+ * and only atomics of these sizes are free of a hidden lock.
+ *****************************************/
+
+#ifndef READ_MOSTLY_HASH_TABLE_H
+#define READ_MOSTLY_HASH_TABLE_H
+
+#include "exception.h"
+#include "Hash_functions.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+template <typename Type, typename Hash = Default_hash<Type> >
+class Read_mostly_hash_table {
+    static_assert( std::is_trivially_copyable<Type>::value,
+                   "Read_mostly_hash_table requires a trivially copyable type" );
+    static_assert( sizeof( Type ) == 1 || sizeof( Type ) == 2 || sizeof( Type ) == 4 || sizeof( Type ) == 8,
+                   "Read_mostly_hash_table requires a type of 1, 2, 4 or 8 bytes, so that readers never lock" );
+
+public:
+    // the number of readers that may exist at once
+    static const int max_readers = 64;
+
+    class reader;
+
+private:
+    // bin states
+    static const unsigned char UNOCCUPIED = 0;
+    static const unsigned char OCCUPIED   = 1;
+    static const unsigned char ERASED     = 2;
+
+    struct bin {
+        std::atomic<unsigned> version;      // odd while being written
+        std::atomic<unsigned char> state;
+        std::atomic<Type> key;
+    };
+
+    // one published generation of the table
+    struct bins {
+        int power;
+        int size;
+        int mask;
+        bin *array;
+        unsigned long long retired;         // epoch in which it was replaced
+    };
+
+    // the epoch announced by one reader, 0 while it is not reading
+    struct alignas(64) reader_slot {
+        std::atomic<unsigned long long> epoch;
+        std::atomic<bool> used;
+    };
+
+    const int m = 5;                        // default array size
+    Hash hasher;                            // hash function object
+    double max_load;                        // load factor that triggers a rebuild
+    std::atomic<bins *> current;            // the bins readers probe
+    std::atomic<int> count;                 // number of elements
+    int erased;                             // number of erased bins
+    int n_rebuilds;                         // number of rebuilds published
+
+    std::mutex writer;                      // serializes writers
+    std::vector<bins *> retired;            // replaced, not yet freed
+    alignas(64) std::atomic<unsigned long long> global_epoch;
+    mutable reader_slot slots[max_readers];
+
+public:
+    // constructors
+    Read_mostly_hash_table();
+    Read_mostly_hash_table(int n, Hash const &h = Hash());
+    ~Read_mostly_hash_table();
+
+    // accessors
+    int size() const;
+    int capacity() const;
+    double load_factor() const;
+    bool empty() const;
+    double max_load_factor() const;
+    int rebuilds() const;
+    int retired_tables() const;
+
+    // mutators
+    bool insert(Type const &obj);
+    bool erase(Type const &obj);
+    void clear();
+    void max_load_factor(double load);
+    int compact();
+
+private:
+    static bins *new_bins(int power);
+    static void delete_bins(bins *b);
+    static bool read_bin(bin const &b, unsigned char &state, Type &key);
+    static void write_bin(bin &b, unsigned char state, Type const &key);
+    static void place(bins *b, std::size_t code, Type const &key);
+
+    int locate(bins const *b, Type const &obj, std::size_t code) const;
+    void rebuild(int power);
+    void publish(bins *b);
+    void reclaim();
+
+    // the table cannot be copied
+    Read_mostly_hash_table(Read_mostly_hash_table const &);
+    Read_mostly_hash_table &operator=(Read_mostly_hash_table const &);
+};
+
+/*
+ * Read_mostly_hash_table::reader
+ *
+ * The handle through which one thread looks entries up.  It holds a
+ * reader slot from construction to destruction, and must not be
+ * shared between threads.  The constructor throws overflow if
+ * max_readers readers of the table already exist.
+ */
+template <typename Type, typename Hash>
+class Read_mostly_hash_table<Type, Hash>::reader {
+private:
+    Read_mostly_hash_table const *table;
+    reader_slot *slot;
+
+public:
+    explicit reader(Read_mostly_hash_table const &t);
+    ~reader();
+
+    bool member(Type const &obj) const;
+
+private:
+    // a reader cannot be copied
+    reader(reader const &);
+    reader &operator=(reader const &);
+};
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Constructors and Destructor                                 * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Constructor: Read_mostly_hash_table(int n, Hash const &h)
+ *
+ * Creates a new hash table with an initial capacity of 2^n that
+ * hashes its entries with h
+ */
+template <typename Type, typename Hash>
+Read_mostly_hash_table<Type, Hash>::Read_mostly_hash_table(int n, Hash const &h):
+hasher( h ),
+max_load( 0.75 ),
+current( new_bins( n ) ),
+count( 0 ),
+erased( 0 ),
+n_rebuilds( 0 ),
+global_epoch( 1 ) {
+    for ( int i = 0; i < max_readers; ++i ) {
+        slots[i].epoch.store( 0 );
+        slots[i].used.store( false );
+    }
+}
+
+/*
+ * Constructor: Read_mostly_hash_table()
+ *
+ * Creates a new hash table with an initial capacity of 2^5
+ */
+template <typename Type, typename Hash>
+Read_mostly_hash_table<Type, Hash>::Read_mostly_hash_table():
+hasher(),
+max_load( 0.75 ),
+current( new_bins( m ) ),
+count( 0 ),
+erased( 0 ),
+n_rebuilds( 0 ),
+global_epoch( 1 ) {
+    for ( int i = 0; i < max_readers; ++i ) {
+        slots[i].epoch.store( 0 );
+        slots[i].used.store( false );
+    }
+}
+
+/*
+ * Destructor
+ *
+ * No reader may be active.
+ */
+template <typename Type, typename Hash>
+Read_mostly_hash_table<Type, Hash>::~Read_mostly_hash_table() {
+    delete_bins( current.load() );
+
+    for ( std::size_t i = 0; i < retired.size(); ++i ) {
+        delete_bins( retired[i] );
+    }
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Accessors                                                   * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: int size()
+ *
+ * Returns: the number of entries
+ */
+template <typename Type, typename Hash>
+int Read_mostly_hash_table<Type, Hash>::size() const {
+    return count.load( std::memory_order_relaxed );
+}
+
+/*
+ * Accessor: int capacity()
+ *
+ * Returns: the number of bins currently published
+ */
+template <typename Type, typename Hash>
+int Read_mostly_hash_table<Type, Hash>::capacity() const {
+    return current.load( std::memory_order_acquire )->size;
+}
+
+/*
+ * Accessor: double load_factor()
+ *
+ * Returns: size() / capacity()
+ */
+template <typename Type, typename Hash>
+double Read_mostly_hash_table<Type, Hash>::load_factor() const {
+    return static_cast<double>( size() ) / capacity();
+}
+
+/*
+ * Accessor: bool empty()
+ *
+ * Returns: true if size() is zero
+ */
+template <typename Type, typename Hash>
+bool Read_mostly_hash_table<Type, Hash>::empty() const {
+    return size() == 0;
+}
+
+/*
+ * Accessor: double max_load_factor()
+ *
+ * Returns: the fraction of the bins that entries and erased bins may
+ *          occupy before the table is rebuilt
+ */
+template <typename Type, typename Hash>
+double Read_mostly_hash_table<Type, Hash>::max_load_factor() const {
+    return max_load;
+}
+
+/*
+ * Accessor: int rebuilds()
+ *
+ * Returns: the number of times new bins were built and published
+ */
+template <typename Type, typename Hash>
+int Read_mostly_hash_table<Type, Hash>::rebuilds() const {
+    return n_rebuilds;
+}
+
+/*
+ * Accessor: int retired_tables()
+ *
+ * Returns: the number of replaced generations of bins that are not
+ *          yet freed because a reader may still be probing them
+ */
+template <typename Type, typename Hash>
+int Read_mostly_hash_table<Type, Hash>::retired_tables() const {
+    return static_cast<int>( retired.size() );
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Mutators                                                    * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: bool insert(Type const &obj)
+ *         Insert obj into the first unoccupied or erased bin of its
+ *         probe sequence.  If the insertion would take the occupied
+ *         and erased bins above max_load_factor(), new bins are built
+ *         first: twice as many if the entries alone need it, otherwise
+ *         as many, which drops the erased bins.
+ *
+ *         An exception is thrown if the table is full at 2^30 bins
+ *
+ * Returns: true if obj was inserted, false if it was already present
+ */
+template <typename Type, typename Hash>
+bool Read_mostly_hash_table<Type, Hash>::insert(Type const &obj) {
+    std::lock_guard<std::mutex> lock( writer );
+    std::size_t code = hasher( obj );
+    bins *b = current.load( std::memory_order_relaxed );
+
+    if ( locate( b, obj, code ) != -1 ) {
+        return false;
+    }
+
+    int n = size();
+
+    if ( n + erased + 1 > max_load * b->size ) {
+        if ( 2 * (n + 1) > max_load * b->size && b->power < 30 ) {
+            rebuild( b->power + 1 );
+        } else {
+            rebuild( b->power );
+        }
+
+        b = current.load( std::memory_order_relaxed );
+    }
+
+    if ( n == b->size ) {
+        throw overflow();
+    }
+
+    int i = static_cast<int>( code & b->mask );
+    unsigned char state;
+    Type key;
+
+    for ( int j = 1; read_bin( b->array[i], state, key ) && state == OCCUPIED; ++j ) {
+        i = (i + j) & b->mask;
+    }
+
+    if ( state == ERASED ) {
+        erased--;
+    }
+
+    write_bin( b->array[i], OCCUPIED, obj );
+    count.store( n + 1, std::memory_order_relaxed );
+    reclaim();
+
+    return true;
+}
+
+/*
+ * Method: bool erase(Type const &obj)
+ *         Mark the bin holding obj as erased.
+ *
+ * Returns: true if obj was erased
+ */
+template <typename Type, typename Hash>
+bool Read_mostly_hash_table<Type, Hash>::erase(Type const &obj) {
+    std::lock_guard<std::mutex> lock( writer );
+    bins *b = current.load( std::memory_order_relaxed );
+    int i = locate( b, obj, hasher( obj ) );
+
+    if ( i == -1 ) {
+        return false;
+    }
+
+    write_bin( b->array[i], ERASED, obj );
+    count.store( size() - 1, std::memory_order_relaxed );
+    erased++;
+    reclaim();
+
+    return true;
+}
+
+/*
+ * Method: void clear()
+ *         Publish empty bins of the initial capacity.
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::clear() {
+    std::lock_guard<std::mutex> lock( writer );
+
+    publish( new_bins( m ) );
+    count.store( 0, std::memory_order_relaxed );
+    erased = 0;
+}
+
+/*
+ * Method: void max_load_factor(double load)
+ *
+ *         An exception is thrown if load is not in (0, 1)
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::max_load_factor(double load) {
+    if ( !(load > 0.0 && load < 1.0) ) {
+        throw illegal_argument();
+    }
+
+    std::lock_guard<std::mutex> lock( writer );
+    max_load = load;
+}
+
+/*
+ * Method: int compact()
+ *         Rebuild the bins at the same capacity, dropping the erased
+ *         bins.  Readers keep probing the old bins until they finish.
+ *
+ * Returns: the number of erased bins reclaimed
+ */
+template <typename Type, typename Hash>
+int Read_mostly_hash_table<Type, Hash>::compact() {
+    std::lock_guard<std::mutex> lock( writer );
+    int reclaimed = erased;
+
+    rebuild( current.load( std::memory_order_relaxed )->power );
+
+    return reclaimed;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Reader                                                      * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Constructor: reader(Read_mostly_hash_table const &t)
+ *
+ * Claims a reader slot of t.
+ *
+ * An exception is thrown if all max_readers slots are in use
+ */
+template <typename Type, typename Hash>
+Read_mostly_hash_table<Type, Hash>::reader::reader(Read_mostly_hash_table const &t):
+table( &t ),
+slot( nullptr ) {
+    for ( int i = 0; i < max_readers; ++i ) {
+        bool unused = false;
+
+        if ( t.slots[i].used.compare_exchange_strong( unused, true ) ) {
+            slot = t.slots + i;
+            return;
+        }
+    }
+
+    throw overflow();
+}
+
+/*
+ * Destructor
+ *
+ * Releases the reader slot.
+ */
+template <typename Type, typename Hash>
+Read_mostly_hash_table<Type, Hash>::reader::~reader() {
+    slot->epoch.store( 0, std::memory_order_release );
+    slot->used.store( false, std::memory_order_release );
+}
+
+/*
+ * Accessor: bool member(Type const &obj)
+ *           Announce the current epoch, so that the bins about to be
+ *           probed are not freed, then probe them.
+ *
+ * Returns: true if obj is in the hash table
+ */
+template <typename Type, typename Hash>
+bool Read_mostly_hash_table<Type, Hash>::reader::member(Type const &obj) const {
+    // the announcement must be visible before the bins are loaded
+    slot->epoch.store( table->global_epoch.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    bins const *b = table->current.load( std::memory_order_acquire );
+    bool found = table->locate( b, obj, table->hasher( obj ) ) != -1;
+
+    slot->epoch.store( 0, std::memory_order_release );
+
+    return found;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Helpers                                                     * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: bins *new_bins(int power)
+ *
+ * Returns: 2^power unoccupied bins
+ */
+template <typename Type, typename Hash>
+typename Read_mostly_hash_table<Type, Hash>::bins *
+Read_mostly_hash_table<Type, Hash>::new_bins(int power) {
+    bins *b = new bins;
+
+    b->power = power;
+    b->size = 1 << power;
+    b->mask = b->size - 1;
+    b->array = new bin[b->size];
+    b->retired = 0;
+
+    for ( int i = 0; i < b->size; ++i ) {
+        b->array[i].version.store( 0, std::memory_order_relaxed );
+        b->array[i].state.store( UNOCCUPIED, std::memory_order_relaxed );
+        b->array[i].key.store( Type(), std::memory_order_relaxed );
+    }
+
+    return b;
+}
+
+/*
+ * Method: void delete_bins(bins *b)
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::delete_bins(bins *b) {
+    delete [] b->array;
+    delete b;
+}
+
+/*
+ * Accessor: bool read_bin(bin const &b, unsigned char &state, Type &key)
+ *           Read a consistent state and key from a bin, retrying
+ *           while the writer is changing it.
+ *
+ * Returns: true
+ */
+template <typename Type, typename Hash>
+bool Read_mostly_hash_table<Type, Hash>::read_bin(bin const &b, unsigned char &state, Type &key) {
+    for (;;) {
+        unsigned before = b.version.load( std::memory_order_acquire );
+
+        if ( (before & 1) == 0 ) {
+            state = b.state.load( std::memory_order_relaxed );
+            key = b.key.load( std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_acquire );
+
+            if ( b.version.load( std::memory_order_relaxed ) == before ) {
+                return true;
+            }
+        }
+    }
+}
+
+/*
+ * Method: void write_bin(bin &b, unsigned char state, Type const &key)
+ *         Change a bin, keeping its version odd while doing so.  Only
+ *         the writer calls this.
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::write_bin(bin &b, unsigned char state, Type const &key) {
+    unsigned version = b.version.load( std::memory_order_relaxed );
+
+    b.version.store( version + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    b.state.store( state, std::memory_order_relaxed );
+    b.key.store( key, std::memory_order_relaxed );
+    b.version.store( version + 2, std::memory_order_release );
+}
+
+/*
+ * Method: void place(bins *b, std::size_t code, Type const &key)
+ *         Store key in the first unoccupied bin of its probe sequence
+ *         in bins that are not yet published.
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::place(bins *b, std::size_t code, Type const &key) {
+    int i = static_cast<int>( code & b->mask );
+
+    for ( int j = 1; b->array[i].state.load( std::memory_order_relaxed ) != UNOCCUPIED; ++j ) {
+        i = (i + j) & b->mask;
+    }
+
+    b->array[i].state.store( OCCUPIED, std::memory_order_relaxed );
+    b->array[i].key.store( key, std::memory_order_relaxed );
+}
+
+/*
+ * Accessor: int locate(bins const *b, Type const &obj, std::size_t code)
+ *           Probe the bins for obj, stopping at the first unoccupied
+ *           bin.
+ *
+ * Returns: the bin holding obj, or -1
+ */
+template <typename Type, typename Hash>
+int Read_mostly_hash_table<Type, Hash>::locate(bins const *b, Type const &obj, std::size_t code) const {
+    int i = static_cast<int>( code & b->mask );
+
+    for ( int j = 1; j <= b->size; ++j ) {
+        unsigned char state;
+        Type key;
+
+        read_bin( b->array[i], state, key );
+
+        if ( state == UNOCCUPIED ) {
+            break;
+        } else if ( state == OCCUPIED && key == obj ) {
+            return i;
+        }
+
+        i = (i + j) & b->mask;
+    }
+
+    return -1;
+}
+
+/*
+ * Method: void rebuild(int power)
+ *         Copy the entries into 2^power new bins and publish them.
+ *         The writer lock is held.
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::rebuild(int power) {
+    bins const *old = current.load( std::memory_order_relaxed );
+    bins *b = new_bins( power );
+
+    for ( int i = 0; i < old->size; ++i ) {
+        if ( old->array[i].state.load( std::memory_order_relaxed ) == OCCUPIED ) {
+            Type key = old->array[i].key.load( std::memory_order_relaxed );
+
+            place( b, hasher( key ), key );
+        }
+    }
+
+    publish( b );
+    erased = 0;
+    n_rebuilds++;
+}
+
+/*
+ * Method: void publish(bins *b)
+ *         Make b the bins that readers probe and retire the previous
+ *         bins in the current epoch, which then ends.  A reader that
+ *         announces a later epoch is certain to load b.
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::publish(bins *b) {
+    bins *old = current.exchange( b, std::memory_order_seq_cst );
+
+    old->retired = global_epoch.fetch_add( 1, std::memory_order_seq_cst );
+    retired.push_back( old );
+    reclaim();
+}
+
+/*
+ * Method: void reclaim()
+ *         Free the retired bins that no reader can still be probing:
+ *         those retired before the epoch announced by every reader
+ *         that is currently reading.
+ */
+template <typename Type, typename Hash>
+void Read_mostly_hash_table<Type, Hash>::reclaim() {
+    if ( retired.empty() ) {
+        return;
+    }
+
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    unsigned long long oldest = global_epoch.load( std::memory_order_relaxed );
+
+    for ( int i = 0; i < max_readers; ++i ) {
+        unsigned long long epoch = slots[i].epoch.load( std::memory_order_acquire );
+
+        if ( epoch != 0 && epoch < oldest ) {
+            oldest = epoch;
+        }
+    }
+
+    std::size_t kept = 0;
+
+    for ( std::size_t i = 0; i < retired.size(); ++i ) {
+        if ( retired[i]->retired < oldest ) {
+            delete_bins( retired[i] );
+        } else {
+            retired[kept++] = retired[i];
+        }
+    }
+
+    retired.resize( kept );
+}
+
+#endif
@@ -0,0 +1,209 @@
+/****************************************************
+ * Executable:   Read_mostly_hash_table
+ * Author:  Keshav Kanatala
+ *
+ * Exercise Read_mostly_hash_table with one writer and several readers.
+ *
+ *   Read_mostly_hash_table stress [threads]
+ *       The writer inserts the keys 0, 1, 2, ... in order from a small
+ *       table, so that it is rebuilt again and again, churns a few
+ *       other keys and compacts now and then; meanwhile each reader
+ *       checks that every key already inserted is found and that no
+ *       key that was never inserted is.  Then every key is erased
+ *       once and must be gone, so no rebuild may have copied a key
+ *       twice.
+ *
+ *   Read_mostly_hash_table bench [threads]
+ *       Run 1, 2, ... up to the given number of readers (by default
+ *       the number of hardware threads) on a large table while the
+ *       writer inserts and erases, and report the lookup throughput.
+ *
+ * Link with -pthread.
+ ****************************************************/
+
+#include <atomic>
+#include <set>
+#include <vector>
+#include "Thread_driver.h"
+#include "Read_mostly_hash_table.h"
+
+typedef Read_mostly_hash_table<int, Murmur_hash<int> > table_t;
+
+/*
+ * The writer: insert the stable keys in order, publishing how many are
+ * in, and between them insert and erase transient keys (at or above
+ * stable) so that erased bins build up and compact() has work to do.
+ * Every result is checked against a private std::set.
+ */
+void stress_writer( table_t &table, int stable, std::atomic<int> &published,
+                    std::set<int> &transient, int &failures ) {
+	Random random( 0 );
+
+	for ( int key = 0; key < stable; ++key ) {
+		if ( !table.insert( key ) ) {
+			++failures;
+		}
+
+		published.store( key + 1, std::memory_order_release );
+
+		// the key is present, so inserting it again must fail
+		if ( table.insert( key ) ) {
+			++failures;
+		}
+
+		for ( int i = 0; i < 4; ++i ) {
+			int other = stable + static_cast<int>( random.next() % 256 );
+
+			if ( random.next() % 2 == 0 ) {
+				failures += table.insert( other ) != transient.insert( other ).second;
+			} else {
+				failures += table.erase( other ) != (transient.erase( other ) > 0);
+			}
+		}
+
+		if ( key % 4096 == 4095 ) {
+			table.compact();
+		}
+	}
+}
+
+/*
+ * A reader: until the writer is done, look up a key that the writer
+ * has published (it must be found) and a negative key (it must not).
+ */
+void stress_reader( table_t const &table, int t, int stable, std::atomic<int> const &published,
+                    std::atomic<bool> const &done, long &lookups, int &failures ) {
+	table_t::reader reader( table );
+	Random random( 1 + t );
+
+	while ( !done.load( std::memory_order_acquire ) ) {
+		int n = published.load( std::memory_order_acquire );
+
+		if ( n > 0 && !reader.member( static_cast<int>( random.next() % n ) ) ) {
+			++failures;
+		}
+
+		if ( reader.member( -1 - static_cast<int>( random.next() % stable ) ) ) {
+			++failures;
+		}
+
+		lookups += 2;
+	}
+}
+
+int stress( int threads ) {
+	int const stable = 1 << 17;
+
+	table_t table( 4 );
+	std::atomic<int> published( 0 );
+	std::atomic<bool> done( false );
+	std::set<int> transient;
+	int writer_failures = 0;
+	std::vector<long> lookups( threads, 0 );
+	std::vector<int> failures( threads, 0 );
+
+	// the writer is the last thread
+	run_threads( threads + 1, [&]( int t ) {
+		if ( t < threads ) {
+			stress_reader( table, t, stable, published, done, lookups[t], failures[t] );
+		} else {
+			stress_writer( table, stable, published, transient, writer_failures );
+			done.store( true, std::memory_order_release );
+		}
+	} );
+
+	int errors = writer_failures;
+	long total_lookups = 0;
+
+	for ( int t = 0; t < threads; ++t ) {
+		errors += failures[t];
+		total_lookups += lookups[t];
+	}
+
+	int expected_size = stable + static_cast<int>( transient.size() );
+
+	if ( table.size() != expected_size ) {
+		std::cout << "Failure in size(): expecting " << expected_size << " but got " << table.size() << std::endl;
+		++errors;
+	}
+
+	std::cout << "during rebuilds: " << threads << " readers, " << total_lookups << " lookups, "
+	          << table.rebuilds() << " rebuilds, " << errors << " errors" << std::endl;
+
+	// a key copied twice would still be found after one erase
+	int duplicates = 0;
+	table_t::reader reader( table );
+
+	for ( int key = 0; key < stable; ++key ) {
+		if ( !table.erase( key ) || reader.member( key ) ) {
+			++duplicates;
+		}
+	}
+
+	if ( table.size() != static_cast<int>( transient.size() ) ) {
+		std::cout << "Failure in size(): expecting " << transient.size() << " but got " << table.size() << std::endl;
+		++duplicates;
+	}
+
+	std::cout << "after erasing:   " << duplicates << " errors" << std::endl;
+
+	return errors + duplicates;
+}
+
+/*
+ * The writer of the benchmark: insert and erase keys outside the range
+ * the readers look up until they finish.
+ */
+void bench_writer( table_t &table, int range, std::atomic<bool> const &done ) {
+	Random random( 0 );
+
+	while ( !done.load( std::memory_order_acquire ) ) {
+		int key = range + static_cast<int>( random.next() % range );
+
+		if ( !table.insert( key ) ) {
+			table.erase( key );
+		}
+	}
+}
+
+void bench_reader( table_t const &table, int t, int range, int ops, long &hits ) {
+	table_t::reader reader( table );
+	Random random( 1 + t );
+	long found = 0;
+
+	for ( int i = 0; i < ops; ++i ) {
+		found += reader.member( static_cast<int>( random.next() % range ) );
+	}
+
+	hits = found;
+}
+
+void bench( int max_threads ) {
+	int const power = 22;
+	int const range = 1 << (power - 2);
+	int const ops = 4000000;
+
+	table_t table( power );
+	std::vector<long> hits( max_threads, 0 );
+
+	for ( int key = 0; key < range; key += 2 ) {
+		table.insert( key );
+	}
+
+	bench_threads( "readers", max_threads, ops, [&]( int threads ) {
+		std::atomic<bool> done( false );
+		std::thread writer( bench_writer, std::ref( table ), range, std::cref( done ) );
+
+		run_threads( threads, [&]( int t ) {
+			bench_reader( table, t, range, ops, hits[t] );
+		} );
+
+		done.store( true, std::memory_order_release );
+		writer.join();
+	} );
+}
+
+int main( int argc, char *argv[] ) {
+	// one reader slot is left for the checks after the stress test
+	return thread_driver( argc, argv, stress, bench, table_t::max_readers - 1 );
+}
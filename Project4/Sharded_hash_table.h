@@ -0,0 +1,419 @@
+/*****************************************
+ * Sharded_hash_table
+ *
+ * Keshav Kanatala
+ *
+ * A thread-safe hash table split into independent shards.  Each shard
+ * is a Quadratic_hash_table with its own reader/writer lock, and each
+ * key belongs to exactly one shard, so threads working on different
+ * shards never wait for one another.
+ *
+ * insert(), erase() and clear() lock a shard exclusively.  member()
+ * only reads a shard that is not resizing, so it shares the lock with
+ * other lookups and waits only for writers; while the shard migrates
+ * its entries, a lookup moves some of them and takes the lock
+ * exclusively.  With QUADRATIC_HASH_TABLE_STATS every lookup updates
+ * the counters of its shard, so lookups always lock exclusively.
+ *
+ * A key is routed by the high bits of its hash code after mixing the
+ * whole code (multiplying by 2^64/phi), while the shard itself picks
+ * bins from the low bits; the two choices are independent even for
+ * the identity hash of small integers.
+ *
+ * Every shard starts with the same capacity and resizes on its own
+ * (its maximum load factor is 0.75), so a shard that receives more
+ * keys grows without rehashing the others.  Each shard starts on a
+ * cache line of its own so that the locks of neighbouring shards do
+ * not share a line.
+ *
+ * size(), load_factor() and clear() visit the shards one at a time;
+ * while other threads insert or erase, size() is not a snapshot of
+ * a single moment.
+ *****************************************/
+
+#ifndef SHARDED_HASH_TABLE_H
+#define SHARDED_HASH_TABLE_H
+
+#include "Quadratic_hash_table.h"
+
+// Quadratic_hash_table.h defines nullptr as a macro, which must not
+// replace the keyword inside the standard headers
+#pragma push_macro("nullptr")
+#undef nullptr
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <pthread.h>
+#pragma pop_macro("nullptr")
+
+template <typename Type, typename Probe = Quadratic_probe, typename Hash = Default_hash<Type> >
+class Sharded_hash_table {
+private:
+    // a reader/writer lock (C++11 has no std::shared_mutex); lock() and
+    // unlock() are exclusive, so it also works with std::lock_guard
+    class shard_lock {
+    private:
+        pthread_rwlock_t rwlock;
+
+    public:
+        shard_lock() {
+            pthread_rwlock_init( &rwlock, nullptr );
+        }
+
+        ~shard_lock() {
+            pthread_rwlock_destroy( &rwlock );
+        }
+
+        void lock() {
+            pthread_rwlock_wrlock( &rwlock );
+        }
+
+        void unlock() {
+            pthread_rwlock_unlock( &rwlock );
+        }
+
+        void lock_shared() {
+            pthread_rwlock_rdlock( &rwlock );
+        }
+
+        void unlock_shared() {
+            pthread_rwlock_unlock( &rwlock );
+        }
+
+    private:
+        shard_lock(shard_lock const &);
+        shard_lock &operator=(shard_lock const &);
+    };
+
+    // holds a shard_lock shared for its lifetime
+    class shared_guard {
+    private:
+        shard_lock &held;
+
+    public:
+        explicit shared_guard(shard_lock &l):
+        held( l ) {
+            held.lock_shared();
+        }
+
+        ~shared_guard() {
+            held.unlock_shared();
+        }
+
+    private:
+        shared_guard(shared_guard const &);
+        shared_guard &operator=(shared_guard const &);
+    };
+
+    struct alignas(64) shard {
+        shard_lock lock;
+        Quadratic_hash_table<Type, Probe, Hash> table;
+
+        shard(int n, Hash const &h):
+        table( n, h ) {
+            table.max_load_factor( 0.75 );
+        }
+    };
+
+    int shard_bits;             // number of shards is 2^shard_bits
+    int n_shards;               // number of shards
+    Hash hasher;                // hash function object
+    char *storage;              // raw memory holding the shards
+    shard *shards;              // the shards, aligned to a cache line
+
+public:
+    // constructors
+    Sharded_hash_table(int n = 5, int s = 0, Hash const &h = Hash());
+    ~Sharded_hash_table();
+
+    // accessors
+    int size() const;
+    int capacity() const;
+    double load_factor() const;
+    bool empty() const;
+    bool member(Type const &obj) const;
+    int shard_count() const;
+    int shard_of(Type const &obj) const;
+    int shard_size(int i) const;
+    int shard_capacity(int i) const;
+
+    // mutators
+    void insert(Type const &obj);
+    bool erase(Type const &obj);
+    void clear();
+    void max_load_factor(double load);
+
+private:
+    // the table cannot be copied
+    Sharded_hash_table(Sharded_hash_table const &);
+    Sharded_hash_table &operator=(Sharded_hash_table const &);
+};
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Constructor and Destructor                                  * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Constructor: Sharded_hash_table(int n, int s, Hash const &h)
+ *
+ * Creates a new sharded hash table of at least s shards (rounded up
+ * to a power of two), each with an initial capacity of 2^n and hashing
+ * its entries with h.  If s is zero, four shards are created for each
+ * hardware thread.
+ */
+template <typename Type, typename Probe, typename Hash>
+Sharded_hash_table<Type, Probe, Hash>::Sharded_hash_table(int n, int s, Hash const &h):
+shard_bits( 0 ),
+n_shards( 1 ),
+hasher( h ),
+storage( nullptr ),
+shards( nullptr ) {
+    if ( s <= 0 ) {
+        s = 4 * std::max( static_cast<int>( std::thread::hardware_concurrency() ), 1 );
+    }
+
+    while ( n_shards < s ) {
+        n_shards <<= 1;
+        shard_bits++;
+    }
+
+    // the allocator only guarantees the alignment of a double
+    storage = new char[(n_shards + 1) * sizeof( shard )];
+    std::size_t misalignment = reinterpret_cast<std::size_t>( storage ) % alignof( shard );
+    shards = reinterpret_cast<shard *>( storage + (alignof( shard ) - misalignment) % alignof( shard ) );
+
+    for ( int i = 0; i < n_shards; ++i ) {
+        new (shards + i) shard( n, h );
+    }
+}
+
+/*
+ * Destructor
+ */
+template <typename Type, typename Probe, typename Hash>
+Sharded_hash_table<Type, Probe, Hash>::~Sharded_hash_table() {
+    for ( int i = 0; i < n_shards; ++i ) {
+        shards[i].~shard();
+    }
+
+    delete [] storage;
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Accessors                                                   * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Accessor: int size()
+ *
+ * Returns: the number of entries in all shards
+ */
+template <typename Type, typename Probe, typename Hash>
+int Sharded_hash_table<Type, Probe, Hash>::size() const {
+    int total = 0;
+
+    for ( int i = 0; i < n_shards; ++i ) {
+        total += shard_size( i );
+    }
+
+    return total;
+}
+
+/*
+ * Accessor: int capacity()
+ *
+ * Returns: the number of bins in all shards
+ */
+template <typename Type, typename Probe, typename Hash>
+int Sharded_hash_table<Type, Probe, Hash>::capacity() const {
+    int total = 0;
+
+    for ( int i = 0; i < n_shards; ++i ) {
+        total += shard_capacity( i );
+    }
+
+    return total;
+}
+
+/*
+ * Accessor: double load_factor()
+ *
+ * Returns: the entries of all shards over the bins of all shards
+ */
+template <typename Type, typename Probe, typename Hash>
+double Sharded_hash_table<Type, Probe, Hash>::load_factor() const {
+    int entries = 0;
+    int bins = 0;
+
+    for ( int i = 0; i < n_shards; ++i ) {
+        shared_guard guard( shards[i].lock );
+
+        entries += shards[i].table.size();
+        bins += shards[i].table.capacity();
+    }
+
+    return static_cast<double>( entries ) / bins;
+}
+
+/*
+ * Accessor: bool empty()
+ *
+ * Returns: true if every shard is empty
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Sharded_hash_table<Type, Probe, Hash>::empty() const {
+    return size() == 0;
+}
+
+/*
+ * Accessor: bool member(Type const &obj)
+ *           Share the lock of the shard of obj unless the shard is
+ *           resizing, in which case the lookup migrates entries and
+ *           must hold the lock alone.
+ *
+ * Returns: true if the shard of obj contains obj
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Sharded_hash_table<Type, Probe, Hash>::member(Type const &obj) const {
+    shard &s = shards[shard_of( obj )];
+
+#ifndef QUADRATIC_HASH_TABLE_STATS
+    {
+        shared_guard guard( s.lock );
+
+        if ( !s.table.resizing() ) {
+            return s.table.member( obj );
+        }
+    }
+#endif
+
+    std::lock_guard<shard_lock> guard( s.lock );
+
+    return s.table.member( obj );
+}
+
+/*
+ * Accessor: int shard_count()
+ *
+ * Returns: the number of shards
+ */
+template <typename Type, typename Probe, typename Hash>
+int Sharded_hash_table<Type, Probe, Hash>::shard_count() const {
+    return n_shards;
+}
+
+/*
+ * Accessor: int shard_of(Type const &obj)
+ *
+ * Returns: the shard obj belongs to: the top bits of its mixed hash
+ *          code
+ */
+template <typename Type, typename Probe, typename Hash>
+int Sharded_hash_table<Type, Probe, Hash>::shard_of(Type const &obj) const {
+    if ( shard_bits == 0 ) {
+        return 0;
+    }
+
+    unsigned long long mixed = static_cast<unsigned long long>( hasher( obj ) ) * 0x9E3779B97F4A7C15ULL;
+
+    return static_cast<int>( mixed >> (64 - shard_bits) );
+}
+
+/*
+ * Accessor: int shard_size(int i)
+ *
+ * Returns: the number of entries in shard i
+ */
+template <typename Type, typename Probe, typename Hash>
+int Sharded_hash_table<Type, Probe, Hash>::shard_size(int i) const {
+    shared_guard guard( shards[i].lock );
+
+    return shards[i].table.size();
+}
+
+/*
+ * Accessor: int shard_capacity(int i)
+ *
+ * Returns: the number of bins in shard i
+ */
+template <typename Type, typename Probe, typename Hash>
+int Sharded_hash_table<Type, Probe, Hash>::shard_capacity(int i) const {
+    shared_guard guard( shards[i].lock );
+
+    return shards[i].table.capacity();
+}
+
+/*********************************************************************
+ * ***************************************************************** *
+ * *                                                               * *
+ * *   Mutators                                                    * *
+ * *                                                               * *
+ * ***************************************************************** *
+ *********************************************************************/
+
+/*
+ * Method: void insert(Type const &obj)
+ *         Insert obj into its shard, which grows if it must.
+ *
+ *         An exception is thrown if the shard is full at 2^30 bins
+ */
+template <typename Type, typename Probe, typename Hash>
+void Sharded_hash_table<Type, Probe, Hash>::insert(Type const &obj) {
+    shard &s = shards[shard_of( obj )];
+    std::lock_guard<shard_lock> guard( s.lock );
+
+    s.table.insert( obj );
+}
+
+/*
+ * Method: bool erase(Type const &obj)
+ *
+ * Returns: true if obj is deleted from its shard
+ */
+template <typename Type, typename Probe, typename Hash>
+bool Sharded_hash_table<Type, Probe, Hash>::erase(Type const &obj) {
+    shard &s = shards[shard_of( obj )];
+    std::lock_guard<shard_lock> guard( s.lock );
+
+    return s.table.erase( obj );
+}
+
+/*
+ * Method: void clear()
+ *         Clear every shard in turn.
+ */
+template <typename Type, typename Probe, typename Hash>
+void Sharded_hash_table<Type, Probe, Hash>::clear() {
+    for ( int i = 0; i < n_shards; ++i ) {
+        std::lock_guard<shard_lock> guard( shards[i].lock );
+
+        shards[i].table.clear();
+    }
+}
+
+/*
+ * Method: void max_load_factor(double load)
+ *         Set the maximum load factor of every shard.
+ *
+ *         An exception is thrown if load is not in (0, 1]
+ */
+template <typename Type, typename Probe, typename Hash>
+void Sharded_hash_table<Type, Probe, Hash>::max_load_factor(double load) {
+    for ( int i = 0; i < n_shards; ++i ) {
+        std::lock_guard<shard_lock> guard( shards[i].lock );
+
+        shards[i].table.max_load_factor( load );
+    }
+}
+
+#endif
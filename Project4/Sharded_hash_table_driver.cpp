@@ -0,0 +1,216 @@
+/****************************************************
+ * Executable:   Sharded_hash_table
+ * Author:  Keshav Kanatala
+ *
+ * Exercise Sharded_hash_table from several threads.
+ *
+ *   Sharded_hash_table stress [threads]
+ *       Each thread inserts, erases and looks up its own keys in shards
+ *       that start small, so that they resize and migrate throughout,
+ *       and checks every lookup against a private std::set; then half
+ *       of the threads insert new keys in order while the other half
+ *       look up the keys already inserted, which must all be found.
+ *
+ *   Sharded_hash_table bench [threads]
+ *       Run a read-mostly workload (7/8 member, 1/16 insert, 1/16 erase)
+ *       and a lookup-only workload with 1, 2, ... up to the given
+ *       number of threads (by default the number of hardware threads)
+ *       and report the throughput.
+ *
+ * Link with -pthread.
+ ****************************************************/
+
+#include <atomic>
+#include <set>
+#include <vector>
+#include "Thread_driver.h"
+#include "Sharded_hash_table.h"
+
+typedef Sharded_hash_table<int, Quadratic_probe, Murmur_hash<int> > table_t;
+
+/*
+ * Disjoint keys: thread t owns the keys congruent to t modulo the
+ * number of threads, so its private std::set predicts every result.
+ */
+void stress_disjoint( table_t &table, int t, int threads, int range, int ops,
+                      std::set<int> &expected, int &failures ) {
+	Random random( t );
+
+	for ( int i = 0; i < ops; ++i ) {
+		int key = static_cast<int>( random.next() % range ) * threads + t;
+
+		switch ( random.next() % 3 ) {
+			case 0:
+				table.insert( key );
+				expected.insert( key );
+				break;
+			case 1:
+				failures += table.erase( key ) != (expected.erase( key ) > 0);
+				break;
+			default:
+				failures += table.member( key ) != (expected.count( key ) > 0);
+				break;
+		}
+	}
+}
+
+/*
+ * A writer of the second phase: insert the negative keys -1 - (w + k
+ * writers) for k = 0, 1, 2, ..., publishing how many are in.
+ */
+void stress_writer( table_t &table, int w, int writers, int keys, std::atomic<int> &published ) {
+	for ( int k = 0; k < keys; ++k ) {
+		table.insert( -1 - (w + k * writers) );
+		published.store( k + 1, std::memory_order_release );
+	}
+}
+
+/*
+ * A reader of the second phase: look up keys that a writer has
+ * published (they must be found) until every writer is done.
+ */
+void stress_reader( table_t const &table, int t, int writers, std::vector<std::atomic<int> > const &published,
+                    std::atomic<int> const &finished, int &failures ) {
+	Random random( 100 + t );
+
+	while ( finished.load( std::memory_order_acquire ) < writers ) {
+		int w = static_cast<int>( random.next() % writers );
+		int n = published[w].load( std::memory_order_acquire );
+
+		if ( n > 0 && !table.member( -1 - (w + static_cast<int>( random.next() % n ) * writers) ) ) {
+			++failures;
+		}
+	}
+}
+
+int stress( int threads ) {
+	int const range = 4096;
+	int const ops = 400000;
+	int const keys = 1 << 16;
+
+	table_t table( 2, threads );
+	std::vector<std::set<int> > expected( threads );
+	std::vector<int> failures( threads, 0 );
+
+	run_threads( threads, [&]( int t ) {
+		stress_disjoint( table, t, threads, range, ops, expected[t], failures[t] );
+	} );
+
+	int errors = 0;
+	int total = 0;
+
+	for ( int t = 0; t < threads; ++t ) {
+		errors += failures[t];
+		total += static_cast<int>( expected[t].size() );
+
+		for ( int key = 0; key < range; ++key ) {
+			if ( table.member( key * threads + t ) != (expected[t].count( key * threads + t ) > 0) ) {
+				++errors;
+			}
+		}
+	}
+
+	if ( table.size() != total ) {
+		std::cout << "Failure in size(): expecting " << total << " but got " << table.size() << std::endl;
+		++errors;
+	}
+
+	std::cout << "disjoint keys:     " << threads << " threads, " << errors << " errors" << std::endl;
+
+	int writers = threads / 2;
+	int readers = threads - writers;
+	std::vector<std::atomic<int> > published( writers );
+	std::atomic<int> finished( 0 );
+	std::vector<int> read_failures( readers, 0 );
+	int read_errors = 0;
+
+	for ( int w = 0; w < writers; ++w ) {
+		published[w].store( 0 );
+	}
+
+	// the writers are the first threads
+	run_threads( threads, [&]( int t ) {
+		if ( t < writers ) {
+			stress_writer( table, t, writers, keys, published[t] );
+			++finished;
+		} else {
+			stress_reader( table, t - writers, writers, published, finished, read_failures[t - writers] );
+		}
+	} );
+
+	for ( int t = 0; t < readers; ++t ) {
+		read_errors += read_failures[t];
+	}
+
+	total += writers * keys;
+
+	if ( table.size() != total ) {
+		std::cout << "Failure in size(): expecting " << total << " but got " << table.size() << std::endl;
+		++read_errors;
+	}
+
+	std::cout << "reads while growing: " << readers << " readers, " << writers << " writers, "
+	          << read_errors << " errors" << std::endl;
+
+	return errors + read_errors;
+}
+
+/*
+ * One thread of the benchmark: a lookup for every r whose top four
+ * bits are not 0 or 1 (all of them if lookups_only), otherwise an
+ * insert or an erase.
+ */
+void bench_worker( table_t &table, int t, int range, int ops, bool lookups_only, long &hits ) {
+	Random random( t );
+	long found = 0;
+
+	for ( int i = 0; i < ops; ++i ) {
+		unsigned int r = random.next();
+		int key = static_cast<int>( r % range );
+
+		switch ( lookups_only ? 2 : r >> 28 ) {
+			case 0:
+				table.insert( key );
+				break;
+			case 1:
+				table.erase( key );
+				break;
+			default:
+				found += table.member( key );
+				break;
+		}
+	}
+
+	hits = found;
+}
+
+void bench( int max_threads, bool lookups_only ) {
+	int const power = 22;
+	int const range = 1 << (power - 1);
+	int const ops = 4000000;
+
+	// as many bins in all as for a single table of 2^power
+	table_t table( power - 6, 64 );
+	std::vector<long> hits( max_threads, 0 );
+
+	for ( int key = 0; key < range; key += 2 ) {
+		table.insert( key );
+	}
+
+	std::cout << (lookups_only ? "member only" : "7/8 member") << std::endl;
+
+	bench_threads( "threads", max_threads, ops, [&]( int threads ) {
+		run_threads( threads, [&]( int t ) {
+			bench_worker( table, t, range, ops, lookups_only, hits[t] );
+		} );
+	} );
+}
+
+void bench( int max_threads ) {
+	bench( max_threads, false );
+	bench( max_threads, true );
+}
+
+int main( int argc, char *argv[] ) {
+	return thread_driver( argc, argv, stress, bench );
+}
@@ -0,0 +1,78 @@
+/*****************************************
+ * Table_image
+ *
+ * Keshav Kanatala
+ *
+ * The file format written by Quadratic_hash_table::save() and read by
+ * Quadratic_hash_table_image:
+ *
+ *   offset 0                 Table_image_header
+ *   control_offset           the control bytes, padded to one group
+ *   array_offset             the entries, bin by bin; bins without an
+ *                            entry are zero
+ *
+ * Both arrays start on a 64-byte boundary, so that a mapping of the
+ * file can be probed in place.  The checksum is the 64-bit FNV-1a
+ * hash of the header (with its checksum zero), the control bytes and
+ * the entries, which catches both corrupted and truncated files.
+ *****************************************/
+
+#ifndef TABLE_IMAGE_H
+#define TABLE_IMAGE_H
+
+#include <cstddef>
+
+// "QHTIMAGE" read as a little-endian integer
+const unsigned long long TABLE_IMAGE_MAGIC   = 0x45474D4954485151ULL;
+const unsigned int       TABLE_IMAGE_VERSION = 2;
+const unsigned int       TABLE_IMAGE_ENDIAN  = 0x01020304;
+
+struct Table_image_header {
+    unsigned long long magic;           // TABLE_IMAGE_MAGIC
+    unsigned int version;               // TABLE_IMAGE_VERSION
+    unsigned int endian;                // TABLE_IMAGE_ENDIAN as written
+    int power;                          // capacity is 2^power
+    int count;                          // number of entries
+    int erased;                         // number of erased bins
+    int probe_width;                    // Probe::width of the table
+    int probe_id;                       // Probe::id of the table
+    int hash_id;                        // Hash::id of the table
+    unsigned int type_size;             // sizeof( Type )
+    unsigned int type_align;            // alignof( Type )
+    unsigned long long seed;            // seed of the hash function
+    unsigned long long control_offset;  // offset of the control bytes
+    unsigned long long control_size;    // number of control bytes
+    unsigned long long array_offset;    // offset of the entries
+    unsigned long long file_size;       // size of the whole file
+    unsigned long long checksum;        // FNV-1a of header, control and entries
+};
+
+const unsigned long long TABLE_IMAGE_FNV_BASIS = 0xCBF29CE484222325ULL;
+
+/*
+ * Function: unsigned long long image_checksum(void const *data, std::size_t n, unsigned long long hash)
+ *
+ * Returns: the FNV-1a hash of n bytes, continuing from hash; start
+ *          with TABLE_IMAGE_FNV_BASIS
+ */
+inline unsigned long long image_checksum( void const *data, std::size_t n, unsigned long long hash ) {
+    unsigned char const *bytes = static_cast<unsigned char const *>( data );
+
+    for ( std::size_t i = 0; i < n; ++i ) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * Function: unsigned long long image_align(unsigned long long offset)
+ *
+ * Returns: offset rounded up to a multiple of 64
+ */
+inline unsigned long long image_align( unsigned long long offset ) {
+    return (offset + 63) & ~63ULL;
+}
+
+#endif
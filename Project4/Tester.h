@@ -31,6 +31,18 @@
  *                       per line.
  *   void process()      Process and run an individual
  *                       test.
+ *   bool dispatch()     Run the current command, either
+ *                       one of the commands every tester
+ *                       shares or by calling process().
+ *
+ * The command 'timing on' times every later command
+ * handed to process() (and 'delete') with a steady
+ * clock and records it in a latency histogram for
+ * that command; 'summary' then also prints the
+ * p50, p99, p99.9 and maximum latency of each
+ * command.  The time includes reading the arguments
+ * and formatting the output, but not writing it.
+ * 'timing off' stops timing.
  *
  * Author:  Douglas Wilhelm Harder
  * Copyright (c) 2006-9 by Douglas Wilhelm Harder.  All rights reserved.
@@ -65,6 +77,13 @@ class Tester {
 
 		int run();
 		virtual void process() = 0;
+
+	protected:
+		bool dispatch();
+
+	private:
+		void timed_process();
+		void timed_delete();
 };
 
 /****************************************************
@@ -141,53 +160,128 @@ int Tester<Class_name>::run() {
 			ece250::history[ece250::count] = command;
 		}
 
-		// start tracking any memory allocations made
-		ece250::allocation_table.start_recording();
+		if ( !dispatch() ) {
+			break;
+		}
+	}
 
-		// There are five key commands
+	return 0;
+}
 
-		if ( command == "exit" ) {
-			std::cout << "Okay" << std::endl;
-			ece250::allocation_table.stop_recording();
-			break;
-		} else if ( command == "delete" ) {
-			delete object;
-			object = nullptr;
-			std::cout << "Okay" << std::endl;
-		} else if ( command == "summary" ) {
-			ece250::allocation_table.summary();
-		} else if ( command == "details" ) {
-			ece250::allocation_table.details();
-		} else if ( command == "memory" ) {
-			int n;
+/****************************************************
+ * bool dispatch()
+ *
+ * Run the current command, recording any memory
+ * allocations it makes: the commands every tester
+ * shares are run here and the rest by process().
+ * The arguments of the command are read from std::cin.
+ *
+ * Returns false if the command is 'exit'.
+ ****************************************************/
 
-			std::cin >> n;
+template <class Class_name>
+bool Tester<Class_name>::dispatch() {
+	// start tracking any memory allocations made
+	ece250::allocation_table.start_recording();
 
-			if ( n == ece250::allocation_table.memory_alloc() ) {
-				std::cout << "Okay" << std::endl;
-			} else {
-				std::cout << "Failure in memory allocation: expecting "
-				          << n << " bytes to be allocated, but "
-				          << ece250::allocation_table.memory_alloc()
-				          << " bytes were allocated" << std::endl;
-			}
-		} else if ( command == "memory_store" ) {
-			ece250::allocation_table.memory_store();
+	// There are five key commands
+
+	if ( command == "exit" ) {
+		std::cout << "Okay" << std::endl;
+		ece250::allocation_table.stop_recording();
+		return false;
+	} else if ( command == "delete" ) {
+		timed_delete();
+	} else if ( command == "summary" ) {
+		ece250::allocation_table.summary();
+		ece250::latency_table.summary();
+	} else if ( command == "details" ) {
+		ece250::allocation_table.details();
+	} else if ( command == "memory" ) {
+		int n;
+
+		std::cin >> n;
+
+		if ( n == ece250::allocation_table.memory_alloc() ) {
 			std::cout << "Okay" << std::endl;
-		} else if ( command == "memory_change" ) {
-			int n;
+		} else {
+			std::cout << "Failure in memory allocation: expecting "
+			          << n << " bytes to be allocated, but "
+			          << ece250::allocation_table.memory_alloc()
+			          << " bytes were allocated" << std::endl;
+		}
+	} else if ( command == "memory_store" ) {
+		ece250::allocation_table.memory_store();
+		std::cout << "Okay" << std::endl;
+	} else if ( command == "memory_change" ) {
+		int n;
+
+		std::cin >> n;
+
+		ece250::allocation_table.memory_change( n );
+	} else if ( command == "timing" ) {
+		std::string mode;
 
-			std::cin >> n;
+		std::cin >> mode;
 
-			ece250::allocation_table.memory_change( n );
+		if ( mode == "on" || mode == "off" ) {
+			ece250::latency_table.enable( mode == "on" );
+			std::cout << "Okay" << std::endl;
 		} else {
-			process();
+			std::cout << "Expecting 'timing on' or 'timing off'" << std::endl;
 		}
+	} else if ( ece250::latency_table.is_enabled() ) {
+		timed_process();
+	} else {
+		process();
+	}
 
-		// stop tracking any memory allocations made
-		ece250::allocation_table.stop_recording();
+	// stop tracking any memory allocations made
+	ece250::allocation_table.stop_recording();
+
+	return true;
+}
+
+/****************************************************
+ * void timed_process()
+ *
+ * Run process() for the current command, holding back its
+ * output, and record how long it took.
+ ****************************************************/
+
+template <class Class_name>
+void Tester<Class_name>::timed_process() {
+	ece250::Stopwatch stopwatch;
+	ece250::Output_capture capture( std::cout );
+
+	stopwatch.start();
+	process();
+	stopwatch.stop();
+
+	capture.release();
+	ece250::latency_table.record( command, stopwatch.get_last_nanoseconds() );
+}
+
+/****************************************************
+ * void timed_delete()
+ *
+ * Delete the object under test, timing it if timing is on.
+ ****************************************************/
+
+template <class Class_name>
+void Tester<Class_name>::timed_delete() {
+	ece250::Stopwatch stopwatch;
+
+	stopwatch.start();
+	delete object;
+	stopwatch.stop();
+
+	object = nullptr;
+
+	if ( ece250::latency_table.is_enabled() ) {
+		ece250::latency_table.record( command, stopwatch.get_last_nanoseconds() );
 	}
 
-	return 0;
+	std::cout << "Okay" << std::endl;
 }
 #endif
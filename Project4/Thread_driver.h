@@ -0,0 +1,129 @@
+/****************************************************
+ * Thread_driver
+ * Author:  Keshav Kanatala
+ *
+ * The parts shared by the drivers that exercise a thread-safe hash
+ * table from several threads; each driver supplies only the checks
+ * and workloads of its own table.
+ *
+ *   Random           a small xorshift generator per thread, so the
+ *                    threads do not share the state of rand()
+ *   run_threads      run a function on threads 0, 1, ..., n - 1 and
+ *                    wait for all of them
+ *   bench_threads    time a workload with 1, 2, ... threads and print
+ *                    the throughput and the speedup over one thread
+ *   thread_driver    the main() of a driver: "stress|bench [threads]"
+ *
+ * Include it before any header that defines nullptr as a macro.
+ ****************************************************/
+
+#ifndef THREAD_DRIVER_H
+#define THREAD_DRIVER_H
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "Hash_functions.h"
+
+class Random {
+	private:
+		unsigned long long state;
+
+	public:
+		explicit Random( unsigned long long seed ):
+		state( murmur_mix( seed + 1 ) ) {
+			// empty constructor
+		}
+
+		unsigned int next() {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+
+			return static_cast<unsigned int>( state >> 32 );
+		}
+};
+
+/*
+ * Call work(t) on a thread of its own for t = 0, 1, ..., n - 1 and
+ * return once every call has returned.
+ */
+template <typename Work>
+void run_threads( int n, Work work ) {
+	std::vector<std::thread> workers;
+
+	for ( int t = 0; t < n; ++t ) {
+		workers.push_back( std::thread( work, t ) );
+	}
+
+	for ( int t = 0; t < n; ++t ) {
+		workers[t].join();
+	}
+}
+
+/*
+ * For threads = 1, 2, ..., max_threads, time run(threads), which
+ * performs ops operations on each of that many threads, and print a
+ * row of the throughput in millions of operations per second.
+ */
+template <typename Run>
+void bench_threads( char const *label, int max_threads, int ops, Run run ) {
+	double single = 0.0;
+
+	std::cout << std::setw( 7 ) << label << "   Mops/s   speedup" << std::endl;
+
+	for ( int threads = 1; threads <= max_threads; ++threads ) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		run( threads );
+
+		double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		double rate = threads * (ops / seconds) / 1e6;
+
+		if ( threads == 1 ) {
+			single = rate;
+		}
+
+		std::cout << std::setw( 7 ) << threads
+		          << std::setw( 9 ) << std::fixed << std::setprecision( 2 ) << rate
+		          << std::setw( 10 ) << rate / single << std::endl;
+	}
+}
+
+/*
+ * Parse "stress|bench [threads]" from the command line, where the
+ * number of threads defaults to the number of hardware threads and
+ * is at most max_threads, and call stress() with at least four
+ * threads (so that they interleave on any machine) or bench().
+ *
+ * Returns: the exit status of the driver
+ */
+inline int thread_driver( int argc, char *argv[], int (*stress)( int ), void (*bench)( int ),
+                          int max_threads = INT_MAX ) {
+	if ( argc < 2 || argc > 3 || (std::strcmp( argv[1], "stress" ) && std::strcmp( argv[1], "bench" )) ) {
+		std::cerr << "Usage: " << argv[0] << " stress|bench [threads]" << std::endl;
+
+		return -1;
+	}
+
+	int threads = (argc == 3) ? std::atoi( argv[2] )
+	                          : static_cast<int>( std::thread::hardware_concurrency() );
+
+	threads = std::min( std::max( threads, 1 ), max_threads );
+
+	if ( !std::strcmp( argv[1], "stress" ) ) {
+		return (stress( std::min( std::max( threads, 4 ), max_threads ) ) == 0) ? 0 : 1;
+	}
+
+	bench( threads );
+
+	return 0;
+}
+
+#endif
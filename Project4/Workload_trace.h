@@ -0,0 +1,84 @@
+/*****************************************
+ * Workload_trace
+ *
+ * Keshav Kanatala
+ *
+ * A compact binary form of a test script, written by
+ * Quadratic_hash_table_workload --binary and read by
+ * Quadratic_hash_table_replay in place of the text:
+ *
+ *   Workload_trace_header
+ *   records, one per command, each an opcode byte followed by its
+ *   arguments in the order the text gives them
+ *   WORKLOAD_END
+ *
+ * An argument that is an int (a size, a capacity, a bin or a power)
+ * takes four bytes, a bool one byte, a load factor eight bytes and a
+ * key key_size bytes, all in the byte order of the machine that wrote
+ * the trace and without padding.  The words "on" and "off" after
+ * WORKLOAD_TIMING are opcodes too.
+ *
+ * Replaying a trace gives the same output as replaying the text
+ * script it stands for, ending with a newline.
+ *****************************************/
+
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+// "QHTTRACE" read as a little-endian integer
+const unsigned long long WORKLOAD_TRACE_MAGIC   = 0x4543415254544851ULL;
+const unsigned int       WORKLOAD_TRACE_VERSION = 1;
+
+struct Workload_trace_header {
+    unsigned long long magic;           // WORKLOAD_TRACE_MAGIC
+    unsigned int version;               // WORKLOAD_TRACE_VERSION
+    unsigned int key_size;              // sizeof( Type ) of the keys
+};
+
+enum Workload_op {
+    WORKLOAD_END,
+    WORKLOAD_NEW,
+    WORKLOAD_NEW_POWER,
+    WORKLOAD_SIZE,
+    WORKLOAD_CAPACITY,
+    WORKLOAD_LOAD_FACTOR,
+    WORKLOAD_EMPTY,
+    WORKLOAD_MEMBER,
+    WORKLOAD_BIN,
+    WORKLOAD_INSERT,
+    WORKLOAD_INSERT_OVERFLOW,
+    WORKLOAD_ERASE,
+    WORKLOAD_CLEAR,
+    WORKLOAD_COUT,
+    WORKLOAD_STATS,
+    WORKLOAD_DELETE,
+    WORKLOAD_SUMMARY,
+    WORKLOAD_DETAILS,
+    WORKLOAD_MEMORY,
+    WORKLOAD_MEMORY_STORE,
+    WORKLOAD_MEMORY_CHANGE,
+    WORKLOAD_TIMING,
+    WORKLOAD_ON,
+    WORKLOAD_OFF,
+    WORKLOAD_EXIT,
+    WORKLOAD_OPS
+};
+
+// the command of each opcode, as written in a text script
+char const *const workload_op_names[WORKLOAD_OPS] = {
+    "", "new", "new:", "size", "capacity", "load_factor", "empty",
+    "member", "bin", "insert", "insert!", "erase", "clear", "cout",
+    "stats", "delete", "summary", "details", "memory", "memory_store",
+    "memory_change", "timing", "on", "off", "exit"
+};
+
+// the arguments of each opcode in order: 'i' an int, 'b' a bool,
+// 'd' a load factor, 'k' a key and 'o' an opcode standing for a word
+char const *const workload_op_arguments[WORKLOAD_OPS] = {
+    "", "", "i", "i", "i", "d", "b",
+    "kb", "ik", "k", "k", "kb", "", "",
+    "", "", "", "", "i", "",
+    "i", "o", "", "", ""
+};
+
+#endif
@@ -9,6 +9,25 @@
 #include <cstring>
 #include <cmath>
 #include <ctime>
+
+// nullptr may already be defined as a macro, which must not replace
+// the keyword inside the standard headers
+#pragma push_macro("nullptr")
+#undef nullptr
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <streambuf>
+#ifdef ECE250_SAMPLE_BYTES
+#include <execinfo.h>
+#endif
+#ifdef ECE250_GUARD_BYTES
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#pragma pop_macro("nullptr")
+
 #include "Exception.h"
 
 #ifndef nullptr
@@ -45,8 +64,18 @@
  * and memory deallocation (delete and delete[]).
  *
  * Each time 'new' or 'new[]' is called, an appropriate entry is
- * set in a hash table 'allocation_table'.  The hash function of any address
- * is the last log[2](array_size) bits.
+ * set in a hash table 'allocation_table'.  The table is sharded by a
+ * hash of the address, each shard with its own lock, and grows as it
+ * fills, so allocations may be made from several threads and in any
+ * number.
+ *
+ * If ECE250_SAMPLE_BYTES is defined, blocks are instead sampled by the
+ * heap profiler 'heap_profile' (about one per ECE250_SAMPLE_BYTES bytes
+ * allocated), and summary() and details() report its estimates.
+ *
+ * If ECE250_GUARD_BYTES is defined, blocks of at least that many bytes
+ * are placed between guard pages (see Guarded_blocks) instead of being
+ * padded, filled, checked and zeroed byte by byte.
  *
  * Each time that 'delete' or 'delete[]' is called, it is checked whether:
  *   1. the memory was actually allocated,
@@ -77,32 +106,273 @@ namespace ece250 {
 	// information about the memory allocation is stored in
 	// an instance of this class
 
+	// Wall-clock time from a monotonic clock; get_last_duration() is in
+	// seconds and get_last_nanoseconds() in whole nanoseconds.
+
 	class Stopwatch {
 		private:
- 			clock_t start_time;
- 			float duration;
+ 			std::chrono::steady_clock::time_point start_time;
+ 			std::chrono::steady_clock::duration duration;
 
 		public:
-			Stopwatch() {
-				duration = 0;
+			Stopwatch():
+			duration( 0 ) {
+				// Empty constructor
 			}
 
 			void start() {
- 				start_time = std::clock();
+ 				start_time = std::chrono::steady_clock::now();
 			}
 
 			void stop() {
- 				clock_t end_time = std::clock();
- 				//this supposed to be milisecond
- 				duration = ((float)end_time - start_time)/CLOCKS_PER_SEC;
+ 				duration = std::chrono::steady_clock::now() - start_time;
 			}
 
  			float get_last_duration() const {
-				return duration;
+				return std::chrono::duration<float>( duration ).count();
+			}
+
+			unsigned long long get_last_nanoseconds() const {
+				return std::chrono::duration_cast<std::chrono::nanoseconds>( duration ).count();
 			}
 	};
 	
 	
+	// A log-linear (HDR-style) histogram of durations in nanoseconds.
+	//
+	// Values below 64 have a bucket each; above that, every power of two
+	// is split into 32 buckets, so a reported percentile is at most about
+	// 3% above the true value.  Values of 2^44 ns (about five hours) or
+	// more share the last bucket.  The maximum is kept exactly.  No memory
+	// is allocated, so recording does not disturb the allocation table.
+
+	class Histogram {
+		private:
+			static const int SUB_BITS = 5;
+			static const int SUB_COUNT = 1 << SUB_BITS;
+			static const int MAX_EXPONENT = 44;
+			static const int BUCKETS = 2*SUB_COUNT + (MAX_EXPONENT - SUB_BITS)*SUB_COUNT;
+
+			unsigned long long counts[BUCKETS];
+			unsigned long long total;
+			unsigned long long maximum;
+
+			static int bucket( unsigned long long ns ) {
+				if ( ns < static_cast<unsigned long long>( 2*SUB_COUNT ) ) {
+					return static_cast<int>( ns );
+				}
+
+				int exponent = 63 - __builtin_clzll( ns );
+
+				if ( exponent > MAX_EXPONENT ) {
+					return BUCKETS - 1;
+				}
+
+				int sub = static_cast<int>( (ns >> (exponent - SUB_BITS)) & (SUB_COUNT - 1) );
+
+				return 2*SUB_COUNT + (exponent - SUB_BITS - 1)*SUB_COUNT + sub;
+			}
+
+			// the largest value that falls into bucket b
+			static unsigned long long highest( int b ) {
+				if ( b < 2*SUB_COUNT ) {
+					return b;
+				}
+
+				int exponent = (b - 2*SUB_COUNT)/SUB_COUNT + SUB_BITS + 1;
+				unsigned long long sub = (b - 2*SUB_COUNT) % SUB_COUNT;
+				int shift = exponent - SUB_BITS;
+
+				return ((SUB_COUNT + sub + 1) << shift) - 1;
+			}
+
+		public:
+			Histogram() {
+				clear();
+			}
+
+			void clear() {
+				std::memset( counts, 0, sizeof( counts ) );
+				total = 0;
+				maximum = 0;
+			}
+
+			void record( unsigned long long ns ) {
+				++counts[bucket( ns )];
+				++total;
+
+				if ( ns > maximum ) {
+					maximum = ns;
+				}
+			}
+
+			unsigned long long count() const {
+				return total;
+			}
+
+			unsigned long long max() const {
+				return maximum;
+			}
+
+			// The value below which a fraction p of the samples fall,
+			// rounded up to the top of its bucket (0 if there are none)
+
+			unsigned long long percentile( double p ) const {
+				if ( total == 0 ) {
+					return 0;
+				}
+
+				unsigned long long rank = static_cast<unsigned long long>( std::ceil( p*total ) );
+				unsigned long long seen = 0;
+
+				if ( rank < 1 ) {
+					rank = 1;
+				}
+
+				for ( int b = 0; b < BUCKETS; ++b ) {
+					seen += counts[b];
+
+					if ( seen >= rank ) {
+						return (highest( b ) < maximum) ? highest( b ) : maximum;
+					}
+				}
+
+				return maximum;
+			}
+	};
+
+	// Holds back what is written to a stream while a command is timed,
+	// so that neither the writes nor the flushes of std::endl are counted;
+	// release() passes the text on.  The buffer is fixed: if a command
+	// prints more than it holds, the excess is passed on at once.
+
+	class Output_capture:public std::streambuf {
+		private:
+			static const int SIZE = 4096;
+
+			std::ostream &stream;
+			std::streambuf *original;
+			char buffer[SIZE];
+
+		public:
+			Output_capture( std::ostream &out ):
+			stream( out ),
+			original( out.rdbuf( this ) ) {
+				setp( buffer, buffer + SIZE );
+			}
+
+			~Output_capture() {
+				release();
+			}
+
+			void release() {
+				if ( original == 0 ) {
+					return;
+				}
+
+				original->sputn( pbase(), pptr() - pbase() );
+				setp( buffer, buffer + SIZE );
+				stream.rdbuf( original );
+				original->pubsync();
+				original = 0;
+			}
+
+		protected:
+			int overflow( int c ) {
+				original->sputn( pbase(), pptr() - pbase() );
+				setp( buffer, buffer + SIZE );
+
+				if ( c != traits_type::eof() ) {
+					*pptr() = static_cast<char>( c );
+					pbump( 1 );
+				}
+
+				return traits_type::not_eof( c );
+			}
+
+			int sync() {
+				// std::endl is flushed when the capture is released
+				return 0;
+			}
+	};
+
+	// A latency histogram for each kind of command run by the tester.
+
+	class Latency_table {
+		private:
+			static const int MAX_COMMANDS = 32;
+			static const int NAME_SIZE = 32;
+
+			char names[MAX_COMMANDS][NAME_SIZE];
+			Histogram histograms[MAX_COMMANDS];
+			int commands;
+			bool enabled;
+
+		public:
+			Latency_table():
+			commands( 0 ),
+			enabled( false ) {
+				// Empty constructor
+			}
+
+			void enable( bool on ) {
+				enabled = on;
+			}
+
+			bool is_enabled() const {
+				return enabled;
+			}
+
+			// Commands beyond the first MAX_COMMANDS kinds are not recorded
+
+			void record( std::string const &command, unsigned long long ns ) {
+				int i = 0;
+
+				while ( i < commands && std::strncmp( names[i], command.c_str(), NAME_SIZE - 1 ) != 0 ) {
+					++i;
+				}
+
+				if ( i == commands ) {
+					if ( commands == MAX_COMMANDS ) {
+						return;
+					}
+
+					std::strncpy( names[i], command.c_str(), NAME_SIZE - 1 );
+					names[i][NAME_SIZE - 1] = '\0';
+					histograms[i].clear();
+					++commands;
+				}
+
+				histograms[i].record( ns );
+			}
+
+			void clear() {
+				commands = 0;
+			}
+
+			// Print the latency percentiles of each command, if any were timed
+
+			void summary() const {
+				if ( commands == 0 ) {
+					return;
+				}
+
+				std::cout << "Latency of each command in nanoseconds:" << std::endl;
+				std::cout << "  Command           Count        p50        p99      p99.9        max" << std::endl;
+
+				for ( int i = 0; i < commands; ++i ) {
+					Histogram const &h = histograms[i];
+
+					std::cout << "  " << std::left << std::setw( 14 ) << names[i] << std::right
+					          << std::setw( 8 ) << h.count()
+					          << std::setw( 11 ) << h.percentile( 0.5 )
+					          << std::setw( 11 ) << h.percentile( 0.99 )
+					          << std::setw( 11 ) << h.percentile( 0.999 )
+					          << std::setw( 11 ) << h.max() << std::endl;
+				}
+			}
+	};
+
 	class Allocation {
 		public:
 			void *address;
@@ -127,37 +397,733 @@ namespace ece250 {
 			}
 	};
 
-	int to_int( int *ptr ) {
-		int result = *ptr;
+#ifdef ECE250_SAMPLE_BYTES
+	// A sampling heap profiler, which the global new and delete use in
+	// place of the allocation table when ECE250_SAMPLE_BYTES is defined
+	// (for example, -DECE250_SAMPLE_BYTES=524288).
+	//
+	// Each thread counts down the bytes that it allocates.  The block that
+	// takes the count past zero is sampled and a new count is drawn from an
+	// exponential distribution with a mean of ECE250_SAMPLE_BYTES, so the
+	// sampled bytes form a Poisson process.  A block of n bytes is then
+	// sampled with probability p = 1 - exp(-n/ECE250_SAMPLE_BYTES), and a
+	// sample stands for n/p bytes and 1/p blocks, so the estimates are
+	// unbiased.  The call stack of each sample is taken with backtrace()
+	// and the estimates are kept for each distinct stack (a site).
+	//
+	// A block that is not sampled costs a subtraction in new and a read of
+	// a counter in delete; new[] adds no padding and nothing is checked or
+	// zeroed.  The totals are estimates, so 'memory' in a test script will
+	// not match.
+	//
+	// The profile is only zero-initialized, so that it works for blocks
+	// allocated before any constructor runs.
 
-		if ( result < 0 ) {
-			result = result + (1 << (sizeof( int ) - 1));
-		}
+	class Heap_profile {
+		private:
+			static const int DEPTH = 16;        // frames kept per site
+			static const int SKIPPED = 2;       // frames of the profiler itself
+			static const int FILTER = 4096;     // counters of sampled addresses
+			static const int TOP_SITES = 20;    // sites listed by details()
+
+			struct Site {
+				void *frames[DEPTH];
+				int depth;
+				unsigned long long hash;
+				double live_bytes;
+				double live_blocks;
+				double total_bytes;
+				double total_blocks;
+			};
+
+			struct Sample {
+				void *address;              // 0 if empty, ERASED if erased
+				int site;
+				double bytes;
+				double blocks;
+			};
+
+			struct Thread_state {
+				long long bytes_left;       // bytes until the next sample
+				unsigned long long random;  // xorshift state, 0 until seeded
+				bool busy;                  // inside the profiler
+			};
+
+			std::mutex lock;
+			Site *sites;                    // every site seen, in order
+			int site_count;
+			int site_capacity;
+			int *site_index;                // open addressing over sites (-1 is empty)
+			int site_index_size;
+			Sample *samples;                // live samples by address
+			int sample_size;
+			int samples_used;               // live and erased bins
+			int samples_live;               // live bins
+			long long sample_total;         // blocks sampled so far
+			std::atomic<int> filter[FILTER];
+
+			static void *erased() {
+				return reinterpret_cast<void *>( 1 );
+			}
 
-		return result >> 3;
-	}
+			static Thread_state &thread_state() {
+				static thread_local Thread_state state;
 
-	// All instances of an allocation are stored in this chained hash table
+				return state;
+			}
 
-	class HashTable {
+			static unsigned long long mix( unsigned long long x ) {
+				return x * 0x9E3779B97F4A7C15ULL;
+			}
+
+			static int filter_bin( void *ptr ) {
+				return static_cast<int>( mix( reinterpret_cast<size_t>( ptr ) >> 4 ) >> 52 ) & (FILTER - 1);
+			}
+
+			// The bytes until the next sample, exponentially distributed
+
+			static long long next_interval( Thread_state &t ) {
+				t.random ^= t.random << 13;
+				t.random ^= t.random >> 7;
+				t.random ^= t.random << 17;
+
+				double u = ((t.random >> 11) + 1.0) / 9007199254740993.0;
+
+				return static_cast<long long>( -std::log( u ) * ECE250_SAMPLE_BYTES ) + 1;
+			}
+
+			// The bin of ptr in samples, else the empty bin where it would go
+
+			int find_sample( void *ptr ) const {
+				int bin = static_cast<int>( mix( reinterpret_cast<size_t>( ptr ) >> 4 ) >> 20 ) & (sample_size - 1);
+				int free_bin = -1;
+
+				while ( samples[bin].address != 0 && samples[bin].address != ptr ) {
+					if ( free_bin == -1 && samples[bin].address == erased() ) {
+						free_bin = bin;
+					}
+
+					bin = (bin + 1) & (sample_size - 1);
+				}
+
+				return (samples[bin].address == 0 && free_bin != -1) ? free_bin : bin;
+			}
+
+			// The site with the given frames, added if it is new; -1 if there
+			// is no memory
+
+			int find_site( void **frames, int depth, unsigned long long hash ) {
+				if ( 2*(site_count + 1) > site_index_size ) {
+					int n = (site_index_size == 0) ? 64 : 2*site_index_size;
+					int *index = static_cast<int *>( std::malloc( n*sizeof( int ) ) );
+
+					if ( index == 0 ) {
+						return -1;
+					}
+
+					std::memset( index, -1, n*sizeof( int ) );
+
+					for ( int i = 0; i < site_count; ++i ) {
+						int bin = static_cast<int>( sites[i].hash ) & (n - 1);
+
+						while ( index[bin] != -1 ) {
+							bin = (bin + 1) & (n - 1);
+						}
+
+						index[bin] = i;
+					}
+
+					std::free( site_index );
+					site_index = index;
+					site_index_size = n;
+				}
+
+				int bin = static_cast<int>( hash ) & (site_index_size - 1);
+
+				while ( site_index[bin] != -1 ) {
+					Site &s = sites[site_index[bin]];
+
+					if ( s.hash == hash && s.depth == depth
+					     && std::memcmp( s.frames, frames, depth*sizeof( void * ) ) == 0 ) {
+						return site_index[bin];
+					}
+
+					bin = (bin + 1) & (site_index_size - 1);
+				}
+
+				if ( site_count == site_capacity ) {
+					int n = (site_capacity == 0) ? 64 : 2*site_capacity;
+					Site *larger = static_cast<Site *>( std::realloc( sites, n*sizeof( Site ) ) );
+
+					if ( larger == 0 ) {
+						return -1;
+					}
+
+					sites = larger;
+					site_capacity = n;
+				}
+
+				Site &s = sites[site_count];
+
+				std::memset( &s, 0, sizeof( Site ) );
+				std::memcpy( s.frames, frames, depth*sizeof( void * ) );
+				s.depth = depth;
+				s.hash = hash;
+				site_index[bin] = site_count;
+
+				return site_count++;
+			}
+
+			// The bins to rebuild the samples in before adding one: a power of
+			// 2 of at least 1024 and four times the live samples, so a table
+			// full of erased bins is rebuilt at the same size
+
+			int sample_bins() const {
+				int n = 1024;
+
+				while ( n < 4*(samples_live + 1) ) {
+					n *= 2;
+				}
+
+				return n;
+			}
+
+			// Rebuild the samples in n bins, dropping the erased ones
+
+			bool resize_samples( int n ) {
+				Sample *bins = static_cast<Sample *>( std::calloc( n, sizeof( Sample ) ) );
+
+				if ( bins == 0 ) {
+					return false;
+				}
+
+				Sample *old_bins = samples;
+				int old_size = (old_bins == 0) ? 0 : sample_size;
+
+				samples = bins;
+				sample_size = n;
+				samples_used = 0;
+
+				for ( int i = 0; i < old_size; ++i ) {
+					if ( old_bins[i].address != 0 && old_bins[i].address != erased() ) {
+						samples[find_sample( old_bins[i].address )] = old_bins[i];
+						++samples_used;
+					}
+				}
+
+				samples_live = samples_used;
+				std::free( old_bins );
+
+				return true;
+			}
+
+			void sample( Thread_state &t, void *ptr, size_t size ) {
+				if ( t.random == 0 ) {
+					// start counting from this block
+					t.random = mix( reinterpret_cast<size_t>( &t ) ^ static_cast<size_t>( std::time( 0 ) ) ) | 1;
+					t.bytes_left += next_interval( t );
+
+					if ( t.bytes_left > 0 ) {
+						return;
+					}
+				}
+
+				t.bytes_left = next_interval( t );
+
+				if ( t.busy || ptr == 0 ) {
+					return;
+				}
+
+				t.busy = true;
+
+				void *frames[DEPTH + SKIPPED];
+				int depth = ::backtrace( frames, DEPTH + SKIPPED ) - SKIPPED;
+				unsigned long long hash = 0;
+
+				depth = std::max( depth, 0 );
+
+				for ( int i = 0; i < depth; ++i ) {
+					hash = mix( hash ^ reinterpret_cast<size_t>( frames[SKIPPED + i] ) ) ^ (hash >> 29);
+				}
+
+				double n = static_cast<double>( std::max( size, static_cast<size_t>( 1 ) ) );
+				double p = 1.0 - std::exp( -n / ECE250_SAMPLE_BYTES );
+
+				{
+					std::lock_guard<std::mutex> guard( lock );
+
+					int site = find_site( frames + SKIPPED, depth, hash );
+
+					if ( site != -1 && (2*(samples_used + 1) <= sample_size
+					                    || resize_samples( sample_bins() )) ) {
+						int bin = find_sample( ptr );
+
+						if ( samples[bin].address == 0 ) {
+							++samples_used;
+						}
+
+						if ( samples[bin].address != ptr ) {
+							++samples_live;
+						}
+
+						samples[bin].address = ptr;
+						samples[bin].site = site;
+						samples[bin].bytes = n / p;
+						samples[bin].blocks = 1.0 / p;
+
+						sites[site].live_bytes += n / p;
+						sites[site].live_blocks += 1.0 / p;
+						sites[site].total_bytes += n / p;
+						sites[site].total_blocks += 1.0 / p;
+						++sample_total;
+						++filter[filter_bin( ptr )];
+					}
+				}
+
+				t.busy = false;
+			}
+
+		public:
+			// Count a block that new or new[] returned
+
+			void allocated( void *ptr, size_t size ) {
+				Thread_state &t = thread_state();
+
+				t.bytes_left -= static_cast<long long>( size );
+
+				if ( t.bytes_left <= 0 ) {
+					sample( t, ptr, size );
+				}
+			}
+
+			// Drop the sample of a block about to be deleted, if it has one
+
+			void deallocated( void *ptr ) {
+				if ( ptr == 0 || filter[filter_bin( ptr )].load( std::memory_order_relaxed ) == 0 ) {
+					return;
+				}
+
+				std::lock_guard<std::mutex> guard( lock );
+
+				if ( samples == 0 ) {
+					return;
+				}
+
+				Sample &s = samples[find_sample( ptr )];
+
+				if ( s.address == ptr ) {
+					sites[s.site].live_bytes -= s.bytes;
+					sites[s.site].live_blocks -= s.blocks;
+					s.address = erased();
+					--samples_live;
+					--filter[filter_bin( ptr )];
+				}
+			}
+
+			// Print the estimated totals of the live and of all allocated blocks
+
+			void summary() {
+				double live[2] = {0.0, 0.0};
+				double total[2] = {0.0, 0.0};
+				long long n;
+
+				{
+					std::lock_guard<std::mutex> guard( lock );
+
+					for ( int i = 0; i < site_count; ++i ) {
+						live[0] += sites[i].live_bytes;
+						live[1] += sites[i].live_blocks;
+						total[0] += sites[i].total_bytes;
+						total[1] += sites[i].total_blocks;
+					}
+
+					n = sample_total;
+				}
+
+				// rounding may leave a tiny negative remainder
+				live[0] = std::max( live[0], 0.0 );
+				live[1] = std::max( live[1], 0.0 );
+
+				std::cout << "Sampled heap profile (one sample per " << ECE250_SAMPLE_BYTES
+				          << " bytes on average, " << n << " samples):" << std::endl;
+				std::cout << "  Live:       about " << std::fixed << std::setprecision( 0 )
+				          << live[0] << " bytes in " << live[1] << " blocks" << std::endl;
+				std::cout << "  Allocated:  about " << total[0] << " bytes in " << total[1]
+				          << " blocks" << std::defaultfloat << std::setprecision( 6 ) << std::endl;
+			}
+
+			// Print the summary and the sites holding the most live memory, each
+			// with its call stack
+
+			void details() {
+				summary();
+
+				Site *copy = 0;
+				int n = 0;
+
+				{
+					std::lock_guard<std::mutex> guard( lock );
+
+					if ( site_count > 0 ) {
+						copy = static_cast<Site *>( std::malloc( site_count*sizeof( Site ) ) );
+
+						if ( copy != 0 ) {
+							n = site_count;
+							std::memcpy( copy, sites, n*sizeof( Site ) );
+						}
+					}
+				}
+
+				std::sort( copy, copy + n, []( Site const &a, Site const &b ) {
+					return a.live_bytes > b.live_bytes
+					       || (a.live_bytes == b.live_bytes && a.total_bytes > b.total_bytes);
+				} );
+
+				std::cout << std::endl << "SITES BY LIVE MEMORY:" << std::endl;
+				std::cout << "    Live bytes   Live blocks  Allocated bytes" << std::endl;
+				std::cout << std::fixed << std::setprecision( 0 );
+
+				for ( int i = 0; i < n && i < TOP_SITES; ++i ) {
+					std::cout << "  " << std::setw( 12 ) << copy[i].live_bytes
+					          << "  " << std::setw( 12 ) << copy[i].live_blocks
+					          << "  " << std::setw( 15 ) << copy[i].total_bytes << std::endl;
+
+					char **names = ::backtrace_symbols( copy[i].frames, copy[i].depth );
+
+					for ( int j = 0; j < copy[i].depth; ++j ) {
+						if ( names != 0 ) {
+							std::cout << "      " << names[j] << std::endl;
+						} else {
+							std::cout << "      " << copy[i].frames[j] << std::endl;
+						}
+					}
+
+					std::free( names );
+				}
+
+				std::cout << std::defaultfloat << std::setprecision( 6 );
+				std::free( copy );
+			}
+	};
+
+	Heap_profile heap_profile;
+#endif
+
+#ifdef ECE250_GUARD_BYTES
+	// Blocks of at least ECE250_GUARD_BYTES bytes allocated with new or new[]
+	// when ECE250_GUARD_BYTES is defined (for example,
+	// -DECE250_GUARD_BYTES=65536).
+	//
+	// Such a block is not padded: it is mapped on its own pages, between
+	// two pages that cannot be accessed, and placed as close to the end of
+	// its pages as 16-byte alignment allows.  An access past the end (by
+	// more than the alignment leaves) or before the start of the pages
+	// faults at once, and neither new[] nor delete[] touches the contents,
+	// which come from the system already zeroed; memory that is never used
+	// is therefore not reported.
+	//
+	// The blocks are kept in a registry so that delete and delete[] can
+	// tell them from other blocks.  As in the heap profile, an atomic
+	// counting filter of the addresses of the live blocks rejects almost
+	// every other block without taking the lock of the registry.  Like
+	// the heap profile, the registry is only zero-initialized.
+
+	class Guarded_blocks {
 		private:
+			static const size_t ALIGNMENT = 16;
+			static const int FILTER = 4096;     // counters of guarded addresses
+
+			struct Block {
+				void *address;              // 0 if empty, ERASED if erased
+				char *mapping;
+				size_t length;
+			};
+
+			std::mutex lock;
+			Block *blocks;
 			int array_size;
-			Allocation *allocated;
-			int total_memory_alloc;
-			int total_memory_deleted;
-			bool record;
+			int used;                       // live and erased bins
+			std::atomic<int> live;
+			std::atomic<int> filter[FILTER];
+
+			static void *erased() {
+				return reinterpret_cast<void *>( 1 );
+			}
+
+			static int filter_bin( void *ptr ) {
+				return static_cast<int>( (static_cast<unsigned long long>( reinterpret_cast<size_t>( ptr ) >> 4 )
+				                          * 0x9E3779B97F4A7C15ULL) >> 52 ) & (FILTER - 1);
+			}
+
+			// The bin of ptr, else the empty bin where it would go
+
+			int find( void *ptr ) const {
+				int bin = static_cast<int>( (static_cast<unsigned long long>( reinterpret_cast<size_t>( ptr ) >> 4 )
+				                             * 0x9E3779B97F4A7C15ULL) >> 20 ) & (array_size - 1);
+				int free_bin = -1;
+
+				while ( blocks[bin].address != 0 && blocks[bin].address != ptr ) {
+					if ( free_bin == -1 && blocks[bin].address == erased() ) {
+						free_bin = bin;
+					}
+
+					bin = (bin + 1) & (array_size - 1);
+				}
+
+				return (blocks[bin].address == 0 && free_bin != -1) ? free_bin : bin;
+			}
+
+			// The bins to rebuild the registry in before adding a block: a
+			// power of 2 of at least 64 and four times the live blocks
+
+			int bins() const {
+				int n = 64;
+
+				while ( n < 4*(live.load( std::memory_order_relaxed ) + 1) ) {
+					n *= 2;
+				}
+
+				return n;
+			}
+
+			// Rebuild the registry in n bins, dropping the erased ones
+
+			bool resize( int n ) {
+				Block *bins = static_cast<Block *>( std::calloc( n, sizeof( Block ) ) );
+
+				if ( bins == 0 ) {
+					return false;
+				}
+
+				Block *old_bins = blocks;
+				int old_size = (old_bins == 0) ? 0 : array_size;
+
+				blocks = bins;
+				array_size = n;
+				used = 0;
+
+				for ( int i = 0; i < old_size; ++i ) {
+					if ( old_bins[i].address != 0 && old_bins[i].address != erased() ) {
+						blocks[find( old_bins[i].address )] = old_bins[i];
+						++used;
+					}
+				}
+
+				std::free( old_bins );
+
+				return true;
+			}
+
+		public:
+			// Map a block of size bytes between guard pages; 0 if there is
+			// no memory
+
+			void *allocate( size_t size ) {
+				size_t page = static_cast<size_t>( ::sysconf( _SC_PAGESIZE ) );
+				size_t data = (size + page - 1) / page * page;
+				size_t length = data + 2*page;
+				void *mapping = ::mmap( 0, length, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+				if ( mapping == MAP_FAILED ) {
+					return 0;
+				}
+
+				char *first = static_cast<char *>( mapping ) + page;
+
+				if ( ::mprotect( first, data, PROT_READ | PROT_WRITE ) != 0 ) {
+					::munmap( mapping, length );
+					return 0;
+				}
+
+				void *ptr = reinterpret_cast<void *>( reinterpret_cast<size_t>( first + data - size ) & ~(ALIGNMENT - 1) );
+				std::lock_guard<std::mutex> guard( lock );
+
+				if ( 2*(used + 1) > array_size && !resize( bins() ) ) {
+					::munmap( mapping, length );
+					return 0;
+				}
+
+				Block &b = blocks[find( ptr )];
+
+				if ( b.address == 0 ) {
+					++used;
+				}
+
+				b.address = ptr;
+				b.mapping = static_cast<char *>( mapping );
+				b.length = length;
+				++live;
+				++filter[filter_bin( ptr )];
+
+				return ptr;
+			}
+
+			// Whether ptr is a guarded block; the lock is taken only if
+			// the filter holds a guarded block in the bin of ptr
+
+			bool contains( void *ptr ) {
+				if ( ptr == 0 || filter[filter_bin( ptr )].load( std::memory_order_relaxed ) == 0 ) {
+					return false;
+				}
+
+				std::lock_guard<std::mutex> guard( lock );
+
+				return blocks[find( ptr )].address == ptr;
+			}
+
+			// Unmap a guarded block
+
+			void release( void *ptr ) {
+				char *mapping = 0;
+				size_t length = 0;
+
+				{
+					std::lock_guard<std::mutex> guard( lock );
+					Block &b = blocks[find( ptr )];
+
+					if ( b.address != ptr ) {
+						return;
+					}
+
+					mapping = b.mapping;
+					length = b.length;
+					b.address = erased();
+					--live;
+					--filter[filter_bin( ptr )];
+				}
+
+				::munmap( mapping, length );
+			}
+	};
+
+	Guarded_blocks guarded_blocks;
+#endif
+
+	// All instances of an allocation are stored in this hash table.
+	//
+	// The table is split into SHARDS shards, chosen by a hash of the
+	// address, each with its own lock, so threads that allocate at the
+	// same time rarely wait for one another.  A shard is an open-addressing
+	// table with linear probing that doubles once it is half full, so
+	// insert() and remove() take O(1) expected time however many blocks
+	// are live.  The storage of the shards comes from calloc() and free(),
+	// never from new, and the totals are atomic.
+	//
+	// As before, an entry is not removed when its memory is deleted, only
+	// marked as deleted (to catch a second delete) until the address is
+	// allocated again; the table therefore holds one entry per distinct
+	// address, which is bounded by the peak size of the heap.  Warnings
+	// are printed once the lock of the shard is released, so printing
+	// cannot deadlock on a shard.
+
+	class HashTable {
+		private:
+			static const int SHARDS = 64;
+			static const int MIN_SHARD_SIZE = 16;
+
+			struct Shard {
+				std::mutex lock;
+				Allocation *allocated;      // the bins (nullptr until first used)
+				int array_size;             // the number of bins, a power of 2
+				int entries;                // bins that hold an address
+			};
+
+			enum Problem {
+				NONE,
+				NEVER_ALLOCATED,
+				EXPECTING_DELETE_ARRAY,
+				EXPECTING_DELETE,
+				DELETED_TWICE,
+				NO_MEMORY
+			};
+
+			Shard shards[SHARDS];
+			std::atomic<long long> total_memory_alloc;
+			std::atomic<long long> total_memory_deleted;
+			std::atomic<bool> record;
+
+			// The shard of an address and the first bin probed within it
+			// come from different bits of a multiplicative hash.
+
+			static unsigned long long hash( void *ptr ) {
+				return static_cast<unsigned long long>( reinterpret_cast<size_t>( ptr ) >> 4 ) * 0x9E3779B97F4A7C15ULL;
+			}
+
+			Shard &shard( unsigned long long h ) {
+				return shards[h >> 58];
+			}
+
+			static int first_bin( Shard const &s, unsigned long long h ) {
+				return static_cast<int>( h >> 16 ) & (s.array_size - 1);
+			}
+
+			// The bin holding ptr, else the empty bin where it would go;
+			// the shard must have bins and must be locked.
+
+			static int find( Shard const &s, void *ptr, unsigned long long h ) {
+				int bin = first_bin( s, h );
+
+				while ( s.allocated[bin].address != 0 && s.allocated[bin].address != ptr ) {
+					bin = (bin + 1) & (s.array_size - 1);
+				}
+
+				return bin;
+			}
+
+			// Move the entries of a locked shard into n bins.
+
+			static bool resize( Shard &s, int n ) {
+				Allocation *bins = static_cast<Allocation *>( std::calloc( n, sizeof( Allocation ) ) );
+
+				if ( bins == 0 ) {
+					return false;
+				}
+
+				Allocation *old_bins = s.allocated;
+				int old_size = (old_bins == 0) ? 0 : s.array_size;
+
+				s.allocated = bins;
+				s.array_size = n;
+
+				for ( int i = 0; i < old_size; ++i ) {
+					if ( old_bins[i].address != 0 ) {
+						s.allocated[find( s, old_bins[i].address, hash( old_bins[i].address ) )] = old_bins[i];
+					}
+				}
+
+				std::free( old_bins );
+
+				return true;
+			}
+
+			static int shard_size( int N ) {
+				int n = MIN_SHARD_SIZE;
+
+				while ( n < N / SHARDS ) {
+					n *= 2;
+				}
+
+				return n;
+			}
 
 		public:
-			// Initialize all of the addresses to 0
+			// The shards are empty until they are first used; as is the total
+			// number of bins that they start with
 
 			HashTable( int as ):
-			array_size( as ),
 			total_memory_alloc( 0 ),
 			total_memory_deleted( 0 ),
 			record( false ) {
-				allocated = new Allocation[array_size];
+				for ( int i = 0; i < SHARDS; ++i ) {
+					shards[i].allocated = 0;
+					shards[i].array_size = shard_size( as );
+					shards[i].entries = 0;
+				}
 			}
 
+			// The storage of the table lives until the program ends: memory
+			// may still be deleted while other globals are destroyed.
+
 			void reserve( int N ) {
 				// N must be a power of 2
 
@@ -165,21 +1131,29 @@ namespace ece250 {
 					throw illegal_argument();
 				}
 
-				delete [] allocated;
-				array_size = N;
-				allocated = new Allocation[array_size];
+				for ( int i = 0; i < SHARDS; ++i ) {
+					std::lock_guard<std::mutex> guard( shards[i].lock );
+					Shard &s = shards[i];
+					int n = shard_size( N );
+
+					if ( s.allocated == 0 ) {
+						s.array_size = std::max( s.array_size, n );
+					} else if ( n > s.array_size ) {
+						resize( s, n );
+					}
+				}
 			}
 
 			int memory_alloc() const {
-				return total_memory_alloc - total_memory_deleted;
+				return static_cast<int>( total_memory_alloc - total_memory_deleted );
 			}
 
 			void memory_store() const {
-				memory_alloc_store = total_memory_alloc - total_memory_deleted;
+				memory_alloc_store = memory_alloc();
 			}
 
 			void memory_change( int n ) const {
-				int memory_alloc_diff = total_memory_alloc - total_memory_deleted - memory_alloc_store;
+				int memory_alloc_diff = memory_alloc() - memory_alloc_store;
 
 				if ( memory_alloc_diff != n ) {
 					std::cout << "WARNING: expecting a change in memory allocation of "
@@ -188,9 +1162,8 @@ namespace ece250 {
 				}
 			}
 
-			// Insert uses the last log[2]( array_size ) bits of the address as the hash function
-			// It finds an unallocated entry in the array and stores the information
-			// about the memory allocation in that entry, including:
+			// Insert stores the information about the memory allocation in
+			// the bin of its address, including:
 			//      The amount of memory allocated,
 			//      Whether new or new[] was used for the allocation, and
 			//      The address of the allocated memory.
@@ -200,109 +1173,131 @@ namespace ece250 {
 					return;
 				}
 
-				// the hash function is the last log[2]( array_size ) bits
-				int hash = to_int( reinterpret_cast<int *>( &ptr ) ) & (array_size - 1);
+				unsigned long long h = hash( ptr );
+				Shard &s = shard( h );
+				Problem problem = NONE;
+
+				{
+					std::lock_guard<std::mutex> guard( s.lock );
 
-				for ( int i = 0; i < array_size; ++i ) {
-					// It may be possible that we are allocated the same memory
-					// location twice (if there are numerous allocations and
-					// deallocations of memory.  Thus, the second check is necessary,
-					// otherwise it may introduce session dependant errors.
+					if ( s.allocated == 0 || 2*(s.entries + 1) > s.array_size ) {
+						if ( !resize( s, s.allocated == 0 ? s.array_size : 2*s.array_size ) ) {
+							problem = NO_MEMORY;
+						}
+					}
 
-					if ( allocated[hash].address == 0 || allocated[hash].address == ptr ) {
-						// Store the address, the amount of memory allocated,
-						// whether or not new[] was used, and set 'deleted' to false.
+					if ( problem == NONE ) {
+						// It may be possible that we are allocated the same memory
+						// location twice (if there are numerous allocations and
+						// deallocations of memory), so an entry for the address
+						// is overwritten.
 
-						allocated[hash] = Allocation( ptr, size, is_array );
+						int bin = find( s, ptr, h );
 
-						// Add the memory allocated to the total memory allocated.
-						total_memory_alloc += size;
+						if ( s.allocated[bin].address == 0 ) {
+							++s.entries;
+						}
 
-						return;
+						s.allocated[bin] = Allocation( ptr, size, is_array );
+						total_memory_alloc += size;
 					}
-
-					hash = (hash + 1) & (array_size - 1);
 				}
 
-				std::cout << "WARNING: allocating more memory than is allowed for this project" << std::endl;
-				throw overflow();
+				if ( problem == NO_MEMORY ) {
+					std::cout << "WARNING: allocating more memory than is allowed for this project" << std::endl;
+					throw overflow();
+				}
 			}
 
 			// Remove checks:
 			//     If the given memory location was allocated in the first place, and
 			//     If the appropriate form of delete was used, i.e., delete versus delete[], and
 			//     If delete has already been called on this object
+			// The memory is zeroed unless zero is false.
 
-			size_t remove( void *ptr, bool is_array ) {
+			size_t remove( void *ptr, bool is_array, bool zero = true ) {
 				if ( !record || ptr == 0 ) {
 					return 0;
 				}
 
-				// the hash function is the last log[2]( array_size ) bits
-				int hash = to_int( reinterpret_cast<int *>( &ptr ) ) & ( array_size - 1 );
-
-				// Continue searching until we've checked all bins
-				// or we find an empty bin.
-
-				for ( int i = 0; i < array_size && allocated[hash].address != 0; ++i ) {
-					if ( allocated[hash].address == ptr ) {
-						// First check if:
-						//    1. If the wrong delete was called (e.g., delete[] when new was
-                        			//       used or delete when new[] was used).
-						//    2. If the memory has already been deallocated previously.
-						//
-						// If the deletion is successful, then:
-						//    1. Set the 'deleted' flag to 'true', and
-						//    2. Add the memory deallocated ot the total memory deallocated.
-
-						if ( allocated[hash].is_array  != is_array ) {
-							if ( allocated[hash].is_array ) {
-								std::cout << "WARNING: use 'delete [] ptr;' to free memory allocated with 'ptr = new Class[array_size];'" << std::endl;
-							} else {
-								std::cout << "WARNING: use 'delete ptr;' to free memory allocated with 'ptr = new Class(...);'" << std::endl;
-							}
-
-							throw invalid_deletion();
-						} else if ( allocated[hash].deleted ) {
-							std::cout << "WARNING: calling delete twice on the same memory location: " << ptr << std::endl;
-							throw invalid_deletion();
+				unsigned long long h = hash( ptr );
+				Shard &s = shard( h );
+				Problem problem = NEVER_ALLOCATED;
+				size_t size = 0;
+
+				{
+					std::lock_guard<std::mutex> guard( s.lock );
+
+					if ( s.allocated != 0 ) {
+						Allocation &entry = s.allocated[find( s, ptr, h )];
+
+						if ( entry.address != ptr ) {
+							problem = NEVER_ALLOCATED;
+						} else if ( entry.is_array != is_array ) {
+							problem = entry.is_array ? EXPECTING_DELETE_ARRAY : EXPECTING_DELETE;
+						} else if ( entry.deleted ) {
+							problem = DELETED_TWICE;
+						} else {
+							// Set the 'deleted' flag to 'true', and
+							// add the memory deallocated to the total memory deallocated.
+
+							entry.deleted = true;
+							total_memory_deleted += entry.size;
+							size = entry.size;
+							problem = NONE;
 						}
+					}
+				}
 
-						allocated[hash].deleted = true;
-						total_memory_deleted += allocated[hash].size;
-
+				switch ( problem ) {
+					case NONE:
 						// zero the memory before it is deallocated
-
-						char *cptr = static_cast<char *>( ptr );
-
-						for ( size_t j = 0; j < allocated[hash].size; ++j ) {
-							cptr[j] = 0;
+						if ( zero ) {
+							std::memset( ptr, 0, size );
 						}
 
-						return allocated[hash].size;
-					}
-
-					hash = (hash + 1) & (array_size - 1);
+						return size;
+					case EXPECTING_DELETE_ARRAY:
+						std::cout << "WARNING: use 'delete [] ptr;' to free memory allocated with 'ptr = new Class[array_size];'" << std::endl;
+						throw invalid_deletion();
+					case EXPECTING_DELETE:
+						std::cout << "WARNING: use 'delete ptr;' to free memory allocated with 'ptr = new Class(...);'" << std::endl;
+						throw invalid_deletion();
+					case DELETED_TWICE:
+						std::cout << "WARNING: calling delete twice on the same memory location: " << ptr << std::endl;
+						throw invalid_deletion();
+					default:
+						// If we've gotten this far, this means that the address was
+						// never allocated, and therefore we are calling delete on
+						// something which should be deleted.
+
+						std::cout << "WARNING: deleting a pointer to which memory was never allocated: " << ptr << std::endl;
+						throw invalid_deletion();
 				}
-
-				// If we've gotten this far, this means that the address was
-				// never allocated, and therefore we are calling delete on
-				// something which should be deleted.
-
-				std::cout << "WARNING: deleting a pointer to which memory was never allocated: " << ptr << std::endl;
-				throw invalid_deletion();
 			}
 
 			// Print a difference between the memory allocated and the memory deallocated
+			// (or, when sampling, the estimates of the heap profile)
 
 			void summary() {
+#ifdef ECE250_SAMPLE_BYTES
+				heap_profile.summary();
+#else
 				std::cout << "Memory allocated minus memory deallocated: "
 				     << total_memory_alloc - total_memory_deleted << std::endl;
+#endif
 			}
 
 			// Print the difference between total memory allocated and total memory deallocated.
+			// Each shard is copied under its lock and printed after it is released.
+			// When sampling, the heap profile is printed by site instead.
 
 			void details() {
+#ifdef ECE250_SAMPLE_BYTES
+				heap_profile.details();
+				return;
+#endif
+
 				std::cout << "SUMMARY OF MEMORY ALLOCATION:" << std::endl;
 
 				std::cout << "  Memory allocated:   " << total_memory_alloc << std::endl;
@@ -311,14 +1306,34 @@ namespace ece250 {
 				std::cout << "INDIVIDUAL REPORT OF MEMORY ALLOCATION:" << std::endl;
 				std::cout << "  Address  Using  Deleted  Bytes   " << std::endl;
 
-				for ( int i = 0; i < array_size; ++i ) {
-					if ( allocated[i].address != 0 ) {
-						std::cout << "  " << allocated[i].address
-						          << ( allocated[i].is_array ? "  new[]     " : "  new       " )
-						          << ( allocated[i].deleted  ? "Y    " : "N    " )
-						          << std::setw( 6 )
-						          << allocated[i].size << std::endl;
+				for ( int i = 0; i < SHARDS; ++i ) {
+					Allocation *copy = 0;
+					int n = 0;
+
+					{
+						std::lock_guard<std::mutex> guard( shards[i].lock );
+
+						if ( shards[i].allocated != 0 ) {
+							n = shards[i].array_size;
+							copy = static_cast<Allocation *>( std::malloc( n*sizeof( Allocation ) ) );
+
+							if ( copy != 0 ) {
+								std::memcpy( copy, shards[i].allocated, n*sizeof( Allocation ) );
+							}
+						}
 					}
+
+					for ( int j = 0; copy != 0 && j < n; ++j ) {
+						if ( copy[j].address != 0 ) {
+							std::cout << "  " << copy[j].address
+							          << ( copy[j].is_array ? "  new[]     " : "  new       " )
+							          << ( copy[j].deleted  ? "Y    " : "N    " )
+							          << std::setw( 6 )
+							          << copy[j].size << std::endl;
+						}
+					}
+
+					std::free( copy );
 				}
 			}
 
@@ -374,11 +1389,166 @@ namespace ece250 {
 		return true;
 	}
 
+	// The exponent k of the fit t = c n^k through the points (n[i], t[i]),
+	// found by least squares on log t against log n, with the bounds of
+	// its 95% confidence interval.
+
+	class Growth_fit {
+		public:
+			double exponent;
+			double low;
+			double high;
+			int points;
+
+			Growth_fit():
+			exponent( 0.0 ),
+			low( 0.0 ),
+			high( 0.0 ),
+			points( 0 ) {
+				// Empty constructor
+			}
+	};
+
+	// The two-sided 95% quantile of Student's t distribution with df
+	// degrees of freedom
+
+	double t_quantile_95( int df ) {
+		static const double table[] = {
+			12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+			 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+			 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+		};
+
+		if ( df < 1 ) {
+			return 0.0;
+		}
+
+		return (df <= 30) ? table[df - 1] : 1.96;
+	}
+
+	Growth_fit growth_fit( double const *n, double const *t, int N ) {
+		Growth_fit fit;
+		double sx = 0.0, sy = 0.0;
+
+		fit.points = N;
+
+		if ( N < 2 ) {
+			return fit;
+		}
+
+		for ( int i = 0; i < N; ++i ) {
+			sx += std::log( n[i] );
+			sy += std::log( t[i] );
+		}
+
+		double mx = sx/N, my = sy/N;
+		double sxx = 0.0, sxy = 0.0;
+
+		for ( int i = 0; i < N; ++i ) {
+			double dx = std::log( n[i] ) - mx;
+
+			sxx += dx*dx;
+			sxy += dx*(std::log( t[i] ) - my);
+		}
+
+		if ( sxx == 0.0 ) {
+			return fit;
+		}
+
+		fit.exponent = sxy/sxx;
+
+		double residuals = 0.0;
+
+		for ( int i = 0; i < N; ++i ) {
+			double e = std::log( t[i] ) - my - fit.exponent*(std::log( n[i] ) - mx);
+
+			residuals += e*e;
+		}
+
+		double margin = (N > 2) ? t_quantile_95( N - 2 )*std::sqrt( residuals/(N - 2)/sxx ) : 0.0;
+
+		fit.low = fit.exponent - margin;
+		fit.high = fit.exponent + margin;
+
+		return fit;
+	}
+
+	// The median of N values (the values are reordered)
+
+	double median( double *values, int N ) {
+		if ( N == 0 ) {
+			return 0.0;
+		}
+
+		std::sort( values, values + N );
+
+		return (N % 2 == 1) ? values[N/2] : (values[N/2 - 1] + values[N/2])/2;
+	}
+
+	// A replacement for asymptotic_tester(): given the cost per operation
+	// t[i] measured at sizes n[i] (several runs per size may be given),
+	// check that the cost grows no faster than n^expected.  The check
+	// fails only if the whole confidence interval of the fitted exponent
+	// lies more than tolerance above expected, so noisy timings do not
+	// fail it but a cost that grows with n does.
+
+	bool growth_tester( double const *n, double const *t, int N, double expected, double tolerance,
+	                    Growth_fit *result = 0 ) {
+		Growth_fit fit = growth_fit( n, t, N );
+
+		if ( result != 0 ) {
+			*result = fit;
+		}
+
+		return fit.low <= expected + tolerance;
+	}
+
 	HashTable allocation_table( 8192 );
+	Latency_table latency_table;
 
 	std::string history[1000];
 	int count = 0;
 
+#ifdef ECE250_GUARD_BYTES
+	// new and new[] of a block of at least ECE250_GUARD_BYTES bytes
+
+	void *guarded_new( size_t size, bool is_array ) {
+		void *ptr = guarded_blocks.allocate( size );
+
+		if ( ptr == 0 ) {
+			throw std::bad_alloc();
+		}
+
+#ifdef ECE250_SAMPLE_BYTES
+		(void) is_array;
+		heap_profile.allocated( ptr, size );
+#else
+		allocation_table.insert( ptr, size, is_array );
+#endif
+
+		return ptr;
+	}
+
+	// delete and delete[]: returns false if ptr is not a guarded block;
+	// otherwise the block is unmapped, so it is not zeroed
+
+	bool guarded_delete( void *ptr, bool is_array ) {
+		if ( !guarded_blocks.contains( ptr ) ) {
+			return false;
+		}
+
+#ifdef ECE250_SAMPLE_BYTES
+		(void) is_array;
+		heap_profile.deallocated( ptr );
+#else
+		allocation_table.remove( ptr, is_array, false );
+#endif
+		guarded_blocks.release( ptr );
+
+		return true;
+	}
+#endif
+
 	// Set the contents of the allocated memory to alternating 0s and 1s
 	// 'U' = 0b01010101
 	// Four bytes are therefore 0x55555555 or 1431655765
@@ -490,6 +1660,10 @@ namespace ece250 {
 		}
 	} */
 }
+
+// The replacement operators are kept out of line: inlined into a
+// new-expression, the malloc and free inside them are matched against
+// the expression and reported as a mismatched new and delete.
 	
 /****************************************************************************
  * new
@@ -505,9 +1679,19 @@ namespace ece250 {
  * Return the pointer to the user.
  ****************************************************************************/
 
-void *operator new( size_t size ) throw( std::bad_alloc ) {
+__attribute__((noinline)) void *operator new( size_t size ) throw( std::bad_alloc ) {
+#ifdef ECE250_GUARD_BYTES
+	if ( size >= ECE250_GUARD_BYTES ) {
+		return ece250::guarded_new( size, false );
+	}
+#endif
+
 	void *ptr = malloc( size );
+#ifdef ECE250_SAMPLE_BYTES
+	ece250::heap_profile.allocated( ptr, size );
+#else
 	ece250::allocation_table.insert( ptr, size, false );
+#endif
 	return static_cast<void *>( ptr );
 }
 
@@ -525,8 +1709,18 @@ void *operator new( size_t size ) throw( std::bad_alloc ) {
  * Use free to perform the deallocation.
  ****************************************************************************/
 
-void operator delete( void *ptr ) throw () {
+__attribute__((noinline)) void operator delete( void *ptr ) throw () {
+#ifdef ECE250_GUARD_BYTES
+	if ( ece250::guarded_delete( ptr, false ) ) {
+		return;
+	}
+#endif
+
+#ifdef ECE250_SAMPLE_BYTES
+	ece250::heap_profile.deallocated( ptr );
+#else
 	ece250::allocation_table.remove( ptr, false );
+#endif
 	free( ptr );
 }
 
@@ -544,11 +1738,24 @@ void operator delete( void *ptr ) throw () {
  * Return the pointer to the user.
  ****************************************************************************/
 
-void *operator new[]( size_t size ) throw( std::bad_alloc ) {
+__attribute__((noinline)) void *operator new[]( size_t size ) throw( std::bad_alloc ) {
+#ifdef ECE250_GUARD_BYTES
+	if ( size >= ECE250_GUARD_BYTES ) {
+		return ece250::guarded_new( size, true );
+	}
+#endif
+
+#ifdef ECE250_SAMPLE_BYTES
+	// no padding is added when sampling
+	void *ptr = malloc( size );
+	ece250::heap_profile.allocated( ptr, size );
+	return ptr;
+#else
 	char *ptr = static_cast<char *>( malloc( size + 2*ece250::PAD ) );
 	ece250::allocation_table.insert( static_cast<void *>( ptr + ece250::PAD ), size, true );
 	ece250::initialize_array_bounds( ptr, size + 2*ece250::PAD );
 	return static_cast<void *>( ptr + ece250::PAD );
+#endif
 }
 
 /****************************************************************************
@@ -565,7 +1772,17 @@ void *operator new[]( size_t size ) throw( std::bad_alloc ) {
  * Use free to perform the deallocation.
  ****************************************************************************/
 
-void operator delete[]( void *ptr ) throw () {
+__attribute__((noinline)) void operator delete[]( void *ptr ) throw () {
+#ifdef ECE250_GUARD_BYTES
+	if ( ece250::guarded_delete( ptr, true ) ) {
+		return;
+	}
+#endif
+
+#ifdef ECE250_SAMPLE_BYTES
+	ece250::heap_profile.deallocated( ptr );
+	free( ptr );
+#else
 	size_t size = ece250::allocation_table.remove( ptr, true );
 
 	if ( ece250::allocation_table.is_recording() ) {
@@ -573,6 +1790,7 @@ void operator delete[]( void *ptr ) throw () {
 	}
 
 	free( static_cast<char *>( ptr ) - ece250::PAD );
+#endif
 }
 
 #endif